@@ -31,6 +31,7 @@
 #define GPIOD_PORT15_OUTPUT   (0b01 << 30)
 #define PORT12                (0B01<<12)
 #define PORT15                (0B01<<15)
+#define USART2_TX_SIZE        256			// Transmit buffer, a power of two
 
 /**
  * @brief   A function to initialize UART2 for to receive or transmit characters and strings.
@@ -42,7 +43,8 @@
 void USART2_init(void);
 
 /**
- * @brief   A function to transmit given character input.
+ * @brief   A function to transmit given character input. The character is copied into the transmit buffer and
+ *          sent by the TX empty interrupt, it only waits when the buffer is full.
  *
  * @param   Character to transmit
  *
@@ -50,6 +52,15 @@ void USART2_init(void);
  */
 char USART2_transmit(char input);
 
+/**
+ * @brief   A function to get the room left in the transmit buffer.
+ *
+ * @param   NULL
+ *
+ * @return  Characters that can be transmitted without waiting.
+ */
+uint32_t USART2_tx_free(void);
+
 /**
  * @brief   A function to receive given character transmitted.
  *
@@ -59,6 +70,15 @@ char USART2_transmit(char input);
  */
 char USART2_receive(void);
 
+/**
+ * @brief   A function to check whether a received character is waiting, without blocking.
+ *
+ * @param   NULL
+ *
+ * @return  1 if USART2_receive() would return immediately.
+ */
+int USART2_data_available(void);
+
 /**
  * @brief   A function to receive given string transmitted.
  *
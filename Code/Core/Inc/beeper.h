@@ -40,4 +40,22 @@ void beeper_init(void);
  */
 void beeper_enable(void);
 
+/**
+ * @brief   A function to turn the buzzer on without waiting, beeper_update() turns it off.
+ *
+ * @param   The beep length in milliseconds.
+ *
+ * @return  NULL
+ */
+void beeper_start(uint32_t ms);
+
+/**
+ * @brief   A function to turn the buzzer off once its beep is over, called from the main loop.
+ *
+ * @param   NULL
+ *
+ * @return  NULL
+ */
+void beeper_update(void);
+
 #endif	// __BEEPER_H
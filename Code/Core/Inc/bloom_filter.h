@@ -0,0 +1,87 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   bloom_filter.h
+* @brief  A file declaring a Bloom filter over card UIDs. It answers "certainly unknown" or "maybe known" from
+*         a few bits in RAM, so most foreign cards are rejected before the card tables are searched.
+*         With m bits, k hashes and n cards the false positive rate is about (1 - e^(-k * n / m))^k:
+*         8 bits per card with 5 hashes gives 2.2%, 10 bits per card with 7 hashes gives 0.8%.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 12, 2023
+* @revision 1.0
+*
+*/
+
+#ifndef __BLOOM_FILTER_H
+#define __BLOOM_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Smallest filter size, a power of two from 256 bits to 1 Mbit, holding at least n bits
+#define BLOOM_FILTER_SIZE_FOR(n)	((n) <= 256 ? 256 : (n) <= 512 ? 512 : (n) <= 1024 ? 1024 \
+		: (n) <= 2048 ? 2048 : (n) <= 4096 ? 4096 : (n) <= 8192 ? 8192 : (n) <= 16384 ? 16384 \
+		: (n) <= 32768 ? 32768 : (n) <= 65536 ? 65536 : (n) <= 131072 ? 131072 : (n) <= 262144 ? 262144 \
+		: (n) <= 524288 ? 524288 : 1048576)
+
+/* A filter over caller provided storage */
+typedef struct {
+	uint32_t *bits;			// Bit array, size / 32 words
+	uint32_t size;			// Bits, a power of two
+	uint8_t hashes;			// Bits set per card
+	uint32_t cards;			// Cards added since the last clear
+} bloom_filter_t;
+
+/**
+ * @brief   A function to set up an empty filter.
+ *
+ * @param   filter  Pointer to the filter
+ *          storage Bit array of size / 32 words
+ *          size    Number of bits, a power of two of at least 32
+ *          hashes  Bits set per card
+ *
+ * @return  True if the filter is set up, false if the size is not a power of two.
+ */
+bool bloom_filter_init(bloom_filter_t *filter, uint32_t *storage, uint32_t size, uint8_t hashes);
+
+/**
+ * @brief   A function to remove every card from a filter.
+ *
+ * @param   filter Pointer to the filter
+ *
+ * @return  None.
+ */
+void bloom_filter_clear(bloom_filter_t *filter);
+
+/**
+ * @brief   A function to add a card to a filter.
+ *
+ * @param   filter Pointer to the filter
+ *          uid    Pointer to the UID bytes
+ *          size   UID size
+ *
+ * @return  None.
+ */
+void bloom_filter_add(bloom_filter_t *filter, const uint8_t *uid, uint8_t size);
+
+/**
+ * @brief   A function to check whether a card may have been added to a filter.
+ *
+ * @param   filter Pointer to the filter
+ *          uid    Pointer to the UID bytes
+ *          size   UID size
+ *
+ * @return  False if the card was never added, true if it may have been.
+ */
+bool bloom_filter_may_contain(const bloom_filter_t *filter, const uint8_t *uid, uint8_t size);
+
+#endif /* __BLOOM_FILTER_H */
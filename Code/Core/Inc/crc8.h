@@ -0,0 +1,37 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   crc8.h
+* @brief  A file declaring the CRC-8 (polynomial 0x07, initial value 0) shared by the credential store and the
+*         access journal to check their flash records.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 14, 2023
+* @revision 1.0
+*
+*/
+
+#ifndef __CRC8_H
+#define __CRC8_H
+
+#include <stdint.h>
+
+/**
+ * @brief   A function to compute the CRC-8 of a buffer.
+ *
+ * @param   data   Bytes to check
+ *          length Number of bytes
+ *
+ * @return  CRC-8 of the bytes.
+ */
+uint8_t crc8(const uint8_t *data, uint32_t length);
+
+#endif /* __CRC8_H */
@@ -0,0 +1,103 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   credential_store.h
+* @brief  A file declaring the persistent store of the cards enrolled by the admin. Every change is appended as
+*         a 12 byte record to a log in one of two dedicated flash sectors. The record is committed by its last
+*         word, so a record cut by a power loss is ignored. When the sector is nearly full an idle task copies
+*         the live cards to the other sector, which is erased and then marked active, and the two sectors take
+*         turns so their erases stay even. At boot the log is replayed into the RAM index (credentials.c).
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 13, 2023
+* @revision 1.0
+*
+*/
+
+#ifndef __CREDENTIAL_STORE_H
+#define __CREDENTIAL_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Flash sectors of the log, 128 KB each. They are outside the FLASH region of the linker script.
+#define CREDENTIAL_STORE_SECTOR_A	6
+#define CREDENTIAL_STORE_SECTOR_B	7
+#define CREDENTIAL_STORE_RECORD_SIZE	12
+#define CREDENTIAL_STORE_SPARE_SLOTS	64		// Free slots of the active sector below which the idle task compacts
+#define CREDENTIAL_STORE_ERASE_MAX_MS	2000	// Maximum erase time of a 128 KB sector, datasheet
+
+/* State of the store */
+typedef struct {
+	uint32_t generation;	// Sector switches since the store was first formatted
+	uint32_t records;		// Records in the active sector, the header excluded
+	uint32_t free;			// Records that still fit in the active sector
+	uint32_t torn;			// Records found cut by a power loss at the last mount
+	uint32_t corrupt;		// Records with a bad check byte at the last mount
+	uint32_t cards;			// Cards enrolled
+} credential_store_stats_t;
+
+/**
+ * @brief   A function to mount the store: select the active sector, formatting the store if neither sector holds
+ *          a valid log, and replay the log into the RAM index.
+ *
+ * @param   None
+ *
+ * @return  True on success, false on a flash error or if the RAM index is too small for the log.
+ */
+bool credential_store_init(void);
+
+/**
+ * @brief   A function to enroll a card, it is in the RAM index and in flash when the function returns true. It
+ *          only programs one record, unless more than CREDENTIAL_STORE_SPARE_SLOTS changes were made since
+ *          credential_store_prepare() last ran, in which case it compacts the store itself.
+ *
+ * @param   uid  Pointer to the UID bytes
+ *          size UID size, 4, 7 or 10 bytes
+ *
+ * @return  True on success, false if the size is invalid, the store is full or on a flash error.
+ */
+bool credential_store_add(const uint8_t *uid, uint8_t size);
+
+/**
+ * @brief   A function to withdraw a card.
+ *
+ * @param   uid  Pointer to the UID bytes
+ *          size UID size
+ *
+ * @return  True on success, false if the card is not enrolled or on a flash error.
+ */
+bool credential_store_remove(const uint8_t *uid, uint8_t size);
+
+/**
+ * @brief   A function to move the live cards to the other sector ahead of time, once the active one has fewer
+ *          than CREDENTIAL_STORE_SPARE_SLOTS free slots, so enrolments and withdrawals never erase. The erase
+ *          stalls the whole core for 1 s typical and CREDENTIAL_STORE_ERASE_MAX_MS at most, then every live
+ *          card is programmed again. Call it under the same conditions as journal_prepare(). A card tapped
+ *          just after it starts is read up to CREDENTIAL_STORE_ERASE_MAX_MS plus the copy later than usual,
+ *          once per sector of changes (10922 slots less the live cards).
+ *
+ * @param   None
+ *
+ * @return  True if the live cards were moved.
+ */
+bool credential_store_prepare(void);
+
+/**
+ * @brief   A function to get the state of the store.
+ *
+ * @param   None
+ *
+ * @return  Pointer to the statistics.
+ */
+const credential_store_stats_t* credential_store_get_stats(void);
+
+#endif /* __CREDENTIAL_STORE_H */
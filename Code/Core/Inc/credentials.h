@@ -0,0 +1,120 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   credentials.h
+* @brief  A file declaring the table of cards allowed through the door. Cards are stored as fixed-width binary
+*         UIDs in an open addressing hash table with linear probing, so a lookup costs about one probe whatever
+*         the number of cards.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 10, 2023
+* @revision 1.0
+*
+*/
+
+#ifndef __CREDENTIALS_H
+#define __CREDENTIALS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "rfid.h"
+#include "pool.h"
+
+// Slots in the table, a power of two (2 bytes each). The cards themselves are records of a static pool of
+// CREDENTIALS_MAX_CARDS blocks (11 bytes and a used bit each), so the table takes 10.34 bytes of RAM per slot.
+// The default 1024 slots hold 768 cards in 10.3 KB. Within the RAM budget of the STM32F411 the largest table is
+// 4096 slots, 3072 cards in 41 KB: larger sites belong in the whitelist compiled into flash (whitelist.h). The
+// host bench builds 16384 slots (12288 cards, 166 KB) with a larger budget.
+#ifndef CREDENTIALS_CAPACITY
+#define CREDENTIALS_CAPACITY	1024
+#endif
+#define CREDENTIALS_MAX_CARDS	(CREDENTIALS_CAPACITY / 4 * 3)	// Load factor limit of 75%
+
+// Bytes of RAM the table and the records may take, half of the 128 KB SRAM of the STM32F411
+#ifndef CREDENTIALS_RAM_BUDGET
+#define CREDENTIALS_RAM_BUDGET	65536
+#endif
+
+/* Usage of the table */
+typedef struct {
+	uint32_t count;			// Cards stored
+	uint32_t capacity;		// Cards that can be stored
+	uint32_t lookups;		// Calls to credentials_find()
+	uint32_t probes;		// Slots compared by those calls
+} credentials_stats_t;
+
+/**
+ * @brief   A function to remove every card from the table.
+ *
+ * @param   None
+ *
+ * @return  None.
+ */
+void credentials_clear(void);
+
+/**
+ * @brief   A function to add a card to the table.
+ *
+ * @param   uid  Pointer to the UID bytes, as read by the RC522 without cascade tags
+ *          size UID size, 4, 7 or 10 bytes
+ *
+ * @return  True if the card is in the table, false if the size is invalid or the table is full.
+ */
+bool credentials_add(const uint8_t *uid, uint8_t size);
+
+/**
+ * @brief   A function to remove a card from the table.
+ *
+ * @param   uid  Pointer to the UID bytes
+ *          size UID size
+ *
+ * @return  True if the card was removed, false if it was not in the table.
+ */
+bool credentials_remove(const uint8_t *uid, uint8_t size);
+
+/**
+ * @brief   A function to look a card up in the table.
+ *
+ * @param   uid  Pointer to the UID bytes
+ *          size UID size
+ *
+ * @return  True if the card is in the table.
+ */
+bool credentials_find(const uint8_t *uid, uint8_t size);
+
+/**
+ * @brief   A function to call a function with every card of the table, in no particular order.
+ *
+ * @param   callback Function called with the UID bytes and size of each card
+ *
+ * @return  None.
+ */
+void credentials_for_each(void (*callback)(const uint8_t *uid, uint8_t size));
+
+/**
+ * @brief   A function to get the usage of the table.
+ *
+ * @param   None
+ *
+ * @return  Pointer to the statistics.
+ */
+const credentials_stats_t* credentials_get_stats(void);
+
+/**
+ * @brief   A function to get the occupancy of the pool holding the card records.
+ *
+ * @param   None
+ *
+ * @return  Pointer to the pool statistics.
+ */
+const pool_stats_t* credentials_get_pool_stats(void);
+
+#endif /* __CREDENTIALS_H */
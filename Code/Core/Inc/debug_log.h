@@ -0,0 +1,86 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   debug_log.h
+* @brief  A file declaring the deferred debug log. Drivers record an event id and two arguments into a
+*         lock-free ring buffer in a few stores, the text is formatted later from the main loop so the card
+*         read path never waits on printf or the UART.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 9, 2023
+* @revision 1.0
+*
+*/
+
+#ifndef __DEBUG_LOG_H
+#define __DEBUG_LOG_H
+
+#include <stdint.h>
+
+#define DEBUG_LOG_SIZE		32		// Entries in the ring buffer, a power of two (12 bytes each)
+#define DEBUG_LOG_LINE_SIZE	80		// Longest printed line, with the line end and the terminating zero
+
+/* Events, each has a format string in debug_log.c */
+typedef enum {
+	DEBUG_LOG_RC522_RX4,			// 4 byte response, a is the bytes in FIFO order
+	DEBUG_LOG_RC522_ERROR,			// a is ErrorReg, b is the command
+	DEBUG_LOG_RC522_CRC_SELF_TEST,	// CRC_A self test failed
+	DEBUG_LOG_SPI_TXE_TIMEOUT,		// a is the byte reached, b the transfer size
+	DEBUG_LOG_SPI_RXNE_TIMEOUT,		// a is the byte reached, b the transfer size
+	DEBUG_LOG_SPI_BSY_TIMEOUT,		// a is the byte reached, b the transfer size
+	DEBUG_LOG_CREDENTIAL_STORE_MOUNT,	// a is the number of cards loaded
+	DEBUG_LOG_JOURNAL_MOUNT,		// a is the number of events found
+	DEBUG_LOG_CARD_FILTER_LOAD,		// a is the number of cards in the card filter, b the bits per card
+	DEBUG_LOG_COUNT
+} debug_log_id_t;
+
+/* One recorded event */
+typedef struct {
+	uint32_t ms;		// millis() when it was recorded
+	uint16_t id;		// debug_log_id_t
+	uint16_t b;			// Second argument
+	uint32_t a;			// First argument
+} debug_log_entry_t;
+
+/**
+ * @brief   A function to record an event. Only thread mode code may record, the ring buffer has a single
+ *          producer and a single consumer (debug_log_flush()), so neither side takes a lock or masks interrupts.
+ *          The event is dropped and counted when the buffer is full.
+ *
+ * @param   id Event id
+ *          a  First argument
+ *          b  Second argument
+ *
+ * @return  None.
+ */
+void debug_log(debug_log_id_t id, uint32_t a, uint16_t b);
+
+/**
+ * @brief   A function to format and print recorded events, oldest first, meant to run from the main loop.
+ *          Each call prints at most max + 1 lines of DEBUG_LOG_LINE_SIZE, the extra one counts dropped events.
+ *
+ * @param   write Function printing a string, USART2_string_transmit on the target
+ *          max   Maximum number of events to print in this call, it bounds the time spent in the UART
+ *
+ * @return  Number of events printed.
+ */
+uint8_t debug_log_flush(void (*write)(char *text), uint8_t max);
+
+/**
+ * @brief   A function to get the number of events dropped because the buffer was full.
+ *
+ * @param   None
+ *
+ * @return  Dropped event count.
+ */
+uint32_t debug_log_dropped(void);
+
+#endif /* __DEBUG_LOG_H */
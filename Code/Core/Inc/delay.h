@@ -41,6 +41,34 @@ uint32_t millis(void);
  */
 void systick_init_ms(uint32_t freq);
 
+/**
+ * @brief   A function to get the DWT cycle counter, enabled by systick_init_ms(). It wraps every 2^32 core cycles,
+ *          so intervals are computed as an unsigned difference of two readings.
+ *
+ * @param   NULL
+ *
+ * @return  Current core cycle count.
+ */
+uint32_t cycles(void);
+
+/**
+ * @brief   A function to convert a duration in microseconds to core cycles.
+ *
+ * @param   The duration in microseconds.
+ *
+ * @return  Number of core cycles.
+ */
+uint32_t cycles_from_us(uint32_t us);
+
+/**
+ * @brief   A function to convert a number of core cycles to microseconds.
+ *
+ * @param   The number of core cycles.
+ *
+ * @return  Duration in microseconds.
+ */
+uint32_t cycles_to_us(uint32_t count);
+
 /**
  * @brief   A function to delay the system by the specified milliseconds.
  *
@@ -0,0 +1,69 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   flash.h
+* @brief  A file declaring the APIs to erase and program the internal flash of the STM32F411. Sectors 0-3 are
+*         16 KB, sector 4 is 64 KB and sectors 5-7 are 128 KB. The flash reads as memory, an erased word reads
+*         0xFFFFFFFF and programming can only clear bits.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 13, 2023
+* @revision 1.0
+*
+*/
+
+#ifndef __FLASH_H
+#define __FLASH_H
+
+#include <stdint.h>
+
+#define FLASH_SECTORS		8
+#define FLASH_ERASED_WORD	0xFFFFFFFFU
+
+/**
+ * @brief   A function to get the address of a flash sector.
+ *
+ * @param   sector Sector number
+ *
+ * @return  Address of the first byte of the sector.
+ */
+uintptr_t flash_sector_address(uint8_t sector);
+
+/**
+ * @brief   A function to get the size of a flash sector.
+ *
+ * @param   sector Sector number
+ *
+ * @return  Size in bytes.
+ */
+uint32_t flash_sector_size(uint8_t sector);
+
+/**
+ * @brief   A function to erase a flash sector. Code runs from the same bank, so the CPU stalls for the
+ *          duration of the erase (1-2 s for a 128 KB sector).
+ *
+ * @param   sector Sector number
+ *
+ * @return  0 on success, -1 on a flash error.
+ */
+int8_t flash_erase_sector(uint8_t sector);
+
+/**
+ * @brief   A function to program one word of flash, about 16 us. The word must be erased.
+ *
+ * @param   address Word aligned address
+ *          data    Value to program
+ *
+ * @return  0 on success, -1 on a flash error.
+ */
+int8_t flash_program_word(uintptr_t address, uint32_t data);
+
+#endif /* __FLASH_H */
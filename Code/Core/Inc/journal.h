@@ -0,0 +1,161 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   journal.h
+* @brief  A file declaring the access event journal. Every door decision is recorded with its time, UID,
+*         decision and reason. journal_log() only copies the event into a RAM staging buffer; the main loop
+*         writes staged events to flash with journal_flush(). The flash log is a ring over two sectors, the
+*         oldest sector is erased when the newest is full. A sparse RAM index of every
+*         JOURNAL_INDEX_STRIDE-th event makes a time range query read only the records near the range.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 14, 2023
+* @revision 1.0
+*
+*/
+
+#ifndef __JOURNAL_H
+#define __JOURNAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "rfid.h"
+
+// Flash sectors of the ring, oldest first at the first boot. They are outside the FLASH region of the linker script,
+// which keeps sectors 3-5 (208 KB) in one piece for the code and the site whitelist.
+#define JOURNAL_SECTOR_A		1		// 16 KB, 818 events
+#define JOURNAL_SECTOR_B		2		// 16 KB
+#define JOURNAL_RECORD_SIZE		20
+#define JOURNAL_STAGING_SIZE	16		// Events waiting for flash, a power of two
+#define JOURNAL_INDEX_STRIDE	64		// Events per index entry
+#define JOURNAL_INDEX_SIZE		32		// Index entries, enough for both sectors full
+#define JOURNAL_SPARE_SLOTS		64		// Free slots of the newest sector below which the other one is erased
+#define JOURNAL_ERASE_MAX_MS	500		// Datasheet maximum erase time of a 16 KB sector (250 ms typical)
+
+/* Door decisions */
+typedef enum {
+	JOURNAL_GRANTED,
+	JOURNAL_DENIED,
+	JOURNAL_ENROLLED
+} journal_decision_t;
+
+/* Reasons of a decision */
+typedef enum {
+	JOURNAL_REASON_WHITELIST,				// Card in the site whitelist
+	JOURNAL_REASON_ENROLLED_CARD,			// Card enrolled by the admin
+	JOURNAL_REASON_SECURITY_PASSWORD,		// Unknown card, correct security password
+	JOURNAL_REASON_WRONG_PASSWORD,			// Unknown card, wrong security password
+	JOURNAL_REASON_ADMIN_PASSWORD,			// Card enrolled with the admin password
+	JOURNAL_REASON_WRONG_ADMIN_PASSWORD,	// Enrolment refused, wrong admin password
+	JOURNAL_REASON_STORE_ERROR,				// Enrolment failed, the card could not be written to flash
+	JOURNAL_REASON_PASSWORD_TIMEOUT			// Password not finished in time
+} journal_reason_t;
+
+/* One recorded event */
+typedef struct {
+	uint32_t time;							// Seconds, see journal_time()
+	uint8_t decision;						// journal_decision_t
+	uint8_t reason;							// journal_reason_t
+	uint8_t size;							// UID size
+	uint8_t uid[MFRC522_UID_MAX_SIZE];		// UID without cascade tags
+} journal_event_t;
+
+/* State of the journal */
+typedef struct {
+	uint32_t events;		// Events in flash
+	uint32_t staged;		// Events waiting in RAM
+	uint32_t dropped;		// Events lost because the staging buffer was full
+	uint32_t failed;		// Events lost to a flash error
+	uint32_t torn;			// Records found cut by a power loss at the last mount
+	uint32_t erases;		// Sector erases since the last mount
+	uint32_t scanned;		// Records read by the last query
+} journal_stats_t;
+
+/**
+ * @brief   A function to mount the journal: find the newest sector, rebuild the index and continue the time
+ *          after the last recorded event. Empty or damaged sectors are formatted.
+ *
+ * @param   None
+ *
+ * @return  True on success, false on a flash error.
+ */
+bool journal_init(void);
+
+/**
+ * @brief   A function to get the journal time. The board has no calendar, so this is the number of seconds
+ *          the journal has been running, carried across resets.
+ *
+ * @param   None
+ *
+ * @return  Time in seconds.
+ */
+uint32_t journal_time(void);
+
+/**
+ * @brief   A function to record an event. It only copies the event into the staging buffer, so it never waits
+ *          for flash.
+ *
+ * @param   decision Door decision
+ *          reason   Reason of the decision
+ *          uid      Pointer to the UID of the card
+ *
+ * @return  True if the event is staged, false if the staging buffer is full.
+ */
+bool journal_log(journal_decision_t decision, journal_reason_t reason, const RC522_uid_t *uid);
+
+/**
+ * @brief   A function to write staged events to flash, about 80 us per event. When the newest sector is full
+ *          and journal_prepare() has not erased the oldest one yet, it is erased here, which stalls the CPU
+ *          for about 250 ms.
+ *
+ * @param   max Maximum number of events to write in this call
+ *
+ * @return  Number of events written.
+ */
+uint8_t journal_flush(uint8_t max);
+
+/**
+ * @brief   A function to erase the oldest sector ahead of time, once the newest one has fewer than
+ *          JOURNAL_SPARE_SLOTS free slots, so the flush that fills the newest sector only writes a header.
+ *          The STM32F411 has a single flash bank, so the erase stalls the whole core, instruction fetch
+ *          included, for 250 ms typical and JOURNAL_ERASE_MAX_MS at most. Call it when no event is staged,
+ *          no door decision is in progress and no card is in the field (RC522_field_busy()). A card tapped
+ *          just after the erase starts is then read up to JOURNAL_ERASE_MAX_MS later than usual. This happens
+ *          once per sector of events (818). The events of the oldest sector are lost a little earlier.
+ *
+ * @param   None
+ *
+ * @return  True if a sector was erased.
+ */
+bool journal_prepare(void);
+
+/**
+ * @brief   A function to call a function with every event recorded in a time range, oldest first. Staged
+ *          events are not included.
+ *
+ * @param   from     First second of the range
+ *          to       Last second of the range
+ *          callback Function called with each event
+ *
+ * @return  Number of events in the range.
+ */
+uint32_t journal_query(uint32_t from, uint32_t to, void (*callback)(const journal_event_t *event));
+
+/**
+ * @brief   A function to get the state of the journal.
+ *
+ * @param   None
+ *
+ * @return  Pointer to the statistics.
+ */
+const journal_stats_t* journal_get_stats(void);
+
+#endif /* __JOURNAL_H */
@@ -24,6 +24,10 @@
 #define __KEYPAD_H
 #include "stm32f4xx.h"
 
+#define KEYPAD_ROWS			4
+#define KEYPAD_COLS			3
+#define KEYPAD_DEBOUNCE_MS	50
+
 /**
  * @brief   A function to initialize the keypad.
  *
@@ -42,4 +46,14 @@ void init_keypad(void);
  */
 char* check_key(void);
 
+/**
+ * @brief   A function to scan the keypad once without waiting. A key is reported once when it goes down,
+ *          changes within KEYPAD_DEBOUNCE_MS of the previous change of that key are ignored.
+ *
+ * @param   None.
+ *
+ * @return  The key pressed since the last scan, '\0' if none.
+ */
+char keypad_scan(void);
+
 #endif /* __KEYPAD_H */
@@ -79,6 +79,16 @@ uint8_t SSD1106_init(void);
  */
 void SSD1106_update_screen(void);
 
+/**
+ * @brief   A function to update the OLED display only if the buffer changed since the last update, so the
+ *          I2C transfer runs in its own task instead of inside every drawing call.
+ *
+ * @param   None
+ *
+ * @return  None.
+ */
+void SSD1106_flush(void);
+
 /**
  * @brief   A function to fill the OLED display with the specified color.
  *
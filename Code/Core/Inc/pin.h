@@ -0,0 +1,73 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   pin.h
+* @brief  A file declaring the salted PIN hashes. A PIN is kept as SHA-256(salt || PIN) with a random 16 byte
+*         salt per PIN, so neither the image nor a RAM dump holds it in plain text. Every PIN of up to
+*         PIN_MAX_LENGTH digits fits in one SHA-256 block with the salt, and the digests are compared without an
+*         early exit, so the time of a check does not depend on how many digits were right.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 17, 2023
+* @revision 1.0
+*
+*/
+
+#ifndef __PIN_H
+#define __PIN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sha256.h"
+
+#define PIN_SALT_SIZE	16
+#define PIN_MAX_LENGTH	(SHA256_BLOCK_SIZE - 9 - PIN_SALT_SIZE)	// Longest PIN hashed in one block
+
+/* A stored PIN, made with Simulator/pin_gen */
+typedef struct {
+	uint8_t salt[PIN_SALT_SIZE];
+	uint8_t hash[SHA256_DIGEST_SIZE];
+} pin_hash_t;
+
+/**
+ * @brief   A function to hash a PIN with a salt.
+ *
+ * @param   pin  PIN digits, a string
+ *          salt Salt of PIN_SALT_SIZE bytes
+ *          out  Pointer to the stored PIN to fill
+ *
+ * @return  None.
+ */
+void pin_hash(const char *pin, const uint8_t *salt, pin_hash_t *out);
+
+/**
+ * @brief   A function to compare two byte arrays in a time that depends only on their length.
+ *
+ * @param   a      Pointer to the first array
+ *          b      Pointer to the second array
+ *          length Number of bytes
+ *
+ * @return  True if the arrays are equal.
+ */
+bool pin_equal(const uint8_t *a, const uint8_t *b, uint8_t length);
+
+/**
+ * @brief   A function to check an entered PIN against a stored one. A PIN longer than PIN_MAX_LENGTH is
+ *          hashed like any other and never matches.
+ *
+ * @param   stored Pointer to the stored PIN
+ *          pin    Entered digits, a string
+ *
+ * @return  True if the PIN is right.
+ */
+bool pin_verify(const pin_hash_t *stored, const char *pin);
+
+#endif /* __PIN_H */
@@ -0,0 +1,107 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   pool.h
+* @brief  A file declaring a pool of fixed size blocks over a caller provided static array. Blocks are
+*         handed out by index in O(1): freed blocks are kept in a list threaded through their first two bytes,
+*         blocks never used are taken in order, so a pool needs no set up loop and no heap.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 15, 2023
+* @revision 1.0
+*
+*/
+
+#ifndef __POOL_H
+#define __POOL_H
+
+#include <stdint.h>
+
+#define POOL_NONE	0xFFFF		// No block, at most 65535 blocks per pool
+
+/* Occupancy of a pool */
+typedef struct {
+	uint32_t blocks;		// Blocks in the pool
+	uint32_t used;			// Blocks allocated
+	uint32_t peak;			// Most blocks allocated at once since the last reset
+	uint32_t failures;		// Allocations refused because every block was in use, and frees of free blocks
+} pool_stats_t;
+
+/* A pool, set up with pool_init() or statically with POOL_INIT */
+typedef struct {
+	uint8_t *memory;		// Array of blocks
+	uint16_t block_size;	// Bytes per block, at least 2
+	uint16_t free;			// First freed block, POOL_NONE if there is none
+	uint16_t fresh;			// First block never allocated
+	uint32_t *used;			// One bit per block, set while the block is allocated
+	pool_stats_t stats;
+} pool_t;
+
+// Words of the used bitmap of a pool of blocks
+#define POOL_USED_WORDS(blocks)	(((blocks) + 31) / 32)
+
+// Static initializer of a pool over an array of a block type and a bitmap of POOL_USED_WORDS() words
+#define POOL_INIT(array, bitmap)	{ (uint8_t*) (array), sizeof((array)[0]), POOL_NONE, 0, (bitmap), \
+		{ sizeof(array) / sizeof((array)[0]), 0, 0, 0 } }
+
+/**
+ * @brief   A function to set up an empty pool.
+ *
+ * @param   pool       Pointer to the pool
+ *          memory     Array of blocks
+ *          block_size Bytes per block, at least 2
+ *          blocks     Number of blocks, less than POOL_NONE
+ *          used       Bitmap of POOL_USED_WORDS(blocks) words
+ *
+ * @return  None.
+ */
+void pool_init(pool_t *pool, void *memory, uint16_t block_size, uint16_t blocks, uint32_t *used);
+
+/**
+ * @brief   A function to free every block of a pool at once and restart its statistics.
+ *
+ * @param   pool Pointer to the pool
+ *
+ * @return  None.
+ */
+void pool_reset(pool_t *pool);
+
+/**
+ * @brief   A function to allocate a block. Its content is undefined.
+ *
+ * @param   pool Pointer to the pool
+ *
+ * @return  Block index, POOL_NONE if every block is in use.
+ */
+uint16_t pool_alloc(pool_t *pool);
+
+/**
+ * @brief   A function to give a block back to its pool. A block that is not allocated, freed twice for
+ *          instance, is left alone and counted in the failures.
+ *
+ * @param   pool  Pointer to the pool
+ *          block Block index returned by pool_alloc()
+ *
+ * @return  None.
+ */
+void pool_free(pool_t *pool, uint16_t block);
+
+/**
+ * @brief   A function to get the address of a block.
+ *
+ * @param   pool  Pointer to the pool
+ *          block Block index
+ *
+ * @return  Pointer to the block.
+ */
+void* pool_block(const pool_t *pool, uint16_t block);
+
+#endif /* __POOL_H */
@@ -33,20 +33,32 @@
 
 /* Mifare_One card command word */
 #define PICC_REQIDL           0x26   // find the antenna area does not enter hibernation
-#define PICC_ANTICOLL         0x93   // anti-collision
+#define PICC_REQALL           0x52   // find all the cards in the antenna area, halted ones included
+#define PICC_ANTICOLL         0x93   // anti-collision / select, cascade level 1
+#define PICC_SEL_CL2          0x95   // anti-collision / select, cascade level 2
+#define PICC_SEL_CL3          0x97   // anti-collision / select, cascade level 3
+#define PICC_CASCADE_TAG      0x88   // First UID byte of a level that is not the last one
 #define PICC_HALT           0x50   // Sleep
+#define PICC_AUTH_KEYA        0x60   // Authentication with Key A
+#define PICC_AUTH_KEYB        0x61   // Authentication with Key B
+#define PICC_READ           0x30   // Read a 16 byte block
+#define PICC_WRITE          0xA0   // Write a 16 byte block
+#define PICC_ACK            0x0A   // 4 bit MIFARE acknowledge
 
 /* MFRC522 Registers */
 //Page 0: Command and Status
 #define MFRC522_REG_COMMAND       0x01
 #define MFRC522_REG_COMM_IE_N     0x02
+#define MFRC522_REG_DIV_IE_N      0x03
 #define MFRC522_REG_COMM_IRQ      0x04
 #define MFRC522_REG_DIV_IRQ       0x05
 #define MFRC522_REG_ERROR       0x06
+#define MFRC522_REG_STATUS2       0x08
 #define MFRC522_REG_FIFO_DATA     0x09
 #define MFRC522_REG_FIFO_LEVEL      0x0A
 #define MFRC522_REG_CONTROL       0x0C
 #define MFRC522_REG_BIT_FRAMING     0x0D
+#define MFRC522_REG_COLL        0x0E
 //Page 1: Command
 #define MFRC522_REG_MODE        0x11
 #define MFRC522_REG_TX_CONTROL      0x14
@@ -57,8 +69,112 @@
 #define MFRC522_REG_T_PRESCALER     0x2B
 #define MFRC522_REG_T_RELOAD_H      0x2C
 #define MFRC522_REG_T_RELOAD_L      0x2D
+//Page 3: Test
+#define MFRC522_REG_VERSION       0x37
 
-#define MFRC522_MAX_LEN         16
+#define MFRC522_MAX_LEN         18        // 16 byte block and its CRC_A
+#define MIFARE_BLOCK_SIZE       16
+#define MIFARE_KEY_SIZE         6
+#define MFRC522_FIFO_SIZE       64
+#define MFRC522_DMA_MIN_BURST   8		// Bytes on the bus, address included, from which a FIFO burst uses DMA
+#define MFRC522_MAX_SPI_HZ      10000000  // Maximum SPI clock accepted by the MFRC522
+#define MFRC522_PROBE_READS     8         // Version reads required to accept an SPI clock
+
+/* Interrupt driven card detection, define MFRC522_IRQ_ENABLE when the RC522 IRQ pin is wired to PB1 */
+//#define MFRC522_IRQ_ENABLE
+#define MFRC522_IRQ_TIMEOUT_MS  100       // Guard in case the IRQ line never fires
+
+/* Duty-cycled card detection, define MFRC522_LPCD_ENABLE to power the RC522 down between detection slots */
+//#define MFRC522_LPCD_ENABLE
+#define MFRC522_LPCD_INTERVAL_MS      200     // Default slot period
+#define MFRC522_LPCD_FIELD_SETTLE_US  2000    // Field on time before the REQA, ISO/IEC 14443-3 allows up to 5ms
+#define MFRC522_POWER_UP_TIMEOUT_US   2000    // Deadline for the oscillator to restart after soft power-down
+
+/* Supply currents used for the duty-cycle estimate (typical datasheet values at 3.3V) */
+#define MFRC522_ACTIVE_UA       74000     // IDDD + IDDA + ITVDD with the field on
+#define MFRC522_PDOWN_UA        10        // Soft power-down
+#define MCU_RUN_UA              4000      // STM32F411 run mode at 16 MHz
+#define MCU_SLEEP_UA            1500      // STM32F411 sleep mode (WFI) at 16 MHz
+
+/* Register access tracing into a RAM ring buffer (rfid_trace.h), define MFRC522_TRACE_ENABLE to record */
+//#define MFRC522_TRACE_ENABLE
+
+/* RC522 timer reloads, one tick is 25us with the prescaler of RC522_init() */
+#define MFRC522_TIMER_RELOAD    1000      // 25ms for the MIFARE commands, the card processes them before answering
+#define MFRC522_SHORT_RELOAD    40        // About 1ms for REQA, anti-collision, SELECT and HLTA, cards answer within 100us
+
+/* Default completion deadlines, the RC522 timer is set up for 25ms in RC522_init() */
+#define MFRC522_TRANSCEIVE_TIMEOUT_US   30000
+#define MFRC522_AUTHENT_TIMEOUT_US      30000
+#define MFRC522_CALCCRC_TIMEOUT_US      5000
+
+#define CRC_A_PRESET            0x6363    // ISO/IEC 14443-3 CRC_A initial value
+
+/* ISO/IEC 14443-3 UID sizes and SAK bits */
+#define MFRC522_UID_MAX_SIZE    10        // Triple size UID
+#define MFRC522_CASCADE_LEVELS  3
+#define MFRC522_INVENTORY_MAX   8         // Cards resolved by one RC522_inventory() call in check_access()
+#define MFRC522_INVENTORY_RETRIES 2       // Failed selections tolerated before an inventory ends
+
+/* Recently-seen UID cache, a card is reported once while it stays within the hold-off window */
+#define MFRC522_SEEN_CACHE_SIZE 8
+#define MFRC522_HOLD_OFF_MS     500       // Must be longer than the detection interval
+#define MFRC522_EVENTS_MAX      (MFRC522_INVENTORY_MAX + MFRC522_SEEN_CACHE_SIZE)
+#define PICC_SAK_CASCADE        0x04      // UID not complete, continue with the next cascade level
+#define PICC_SAK_ISO14443_4     0x20      // PICC compliant with ISO/IEC 14443-4 (DESFire, ...)
+
+/* MFRC522 error register bits */
+#define MFRC522_ERR_PROTOCOL    0x01
+#define MFRC522_ERR_PARITY      0x02
+#define MFRC522_ERR_COLL        0x08
+#define MFRC522_ERR_BUFFER_OVFL 0x10
+
+/* Duty-cycled detection statistics */
+typedef struct {
+	uint32_t interval_ms;		// Slot period
+	uint32_t slots;				// Slots run since start-up
+	uint32_t detections;		// Slots in which a card answered
+	uint32_t active_us_last;	// RC522 powered time of the most recent empty slot
+	uint32_t active_us_max;		// Worst case RC522 powered time of an empty slot
+	uint32_t empty_slots;		// Slots in which no card answered
+	uint64_t active_us_sum;		// RC522 powered time of all the empty slots
+	uint32_t avg_current_ua;	// Estimated average supply current of RC522 and MCU without a card, from the mean
+								// powered time of an empty slot
+	uint32_t worst_latency_ms;	// Longest time between a card arriving and its detection
+} RC522_lpcd_stats_t;
+
+/* UID of a selected PICC */
+typedef struct {
+	uint8_t size;							// 4, 7 or 10 bytes
+	uint8_t uid[MFRC522_UID_MAX_SIZE];		// UID without cascade tags
+	uint8_t sak;							// SAK of the last cascade level
+} RC522_uid_t;
+
+/* Card events reported by RC522_poll_events() */
+typedef enum {
+	RC522_EVENT_PRESENTED,	// Card entered the field
+	RC522_EVENT_REMOVED		// Card not seen for the hold-off window
+} RC522_event_type_t;
+
+typedef struct {
+	RC522_event_type_t type;
+	RC522_uid_t uid;
+} RC522_event_t;
+
+/* Progress of a request started with RC522_request_irq_start() */
+typedef enum {
+	RC522_REQUEST_PENDING,	// Neither the answer nor the timer expiry has been signalled yet
+	RC522_REQUEST_NO_CARD,	// No request running, timer expired or the answer was not an ATQA
+	RC522_REQUEST_CARD		// ATQA received
+} RC522_request_state_t;
+
+/* Completion wait settings and statistics of one MFRC522 command */
+typedef struct {
+	uint32_t timeout_us;	// Deadline for the command to complete
+	uint16_t last_polls;	// Status register reads needed by the most recent run
+	uint16_t max_polls;		// Worst case status register reads since start-up
+	uint32_t timeouts;		// Number of runs that hit the deadline
+} RC522_command_timing_t;
 
 /**
  * @brief   A function to initialize RC522 RFID module.
@@ -69,6 +185,69 @@
  */
 void RC522_init(void);
 
+/**
+ * @brief   A function to find the fastest SPI clock at which the RC522 answers reliably.
+ *          The clock is stepped up from fPCLK/256 and every step is verified by reading back
+ *          the version register. The last clock that passed stays selected.
+ *
+ * @param   None
+ *
+ * @return  Selected SPI clock in hertz, 0 if the RC522 never answered (the clock is left unchanged).
+ */
+uint32_t RC522_probe_spi_clock(void);
+
+/**
+ * @brief   A function to enable interrupt driven card detection. PB1 is configured as EXTI1 on the
+ *          falling edge of the (inverted) RC522 IRQ output. RC522_check_card() and RC522_inventory() then
+ *          start a REQA in one call and pick up its answer in a later one instead of polling over SPI, so
+ *          the core can sleep in the caller's idle loop while the RC522 waits for the card.
+ *
+ * @param   None
+ *
+ * @return  None.
+ */
+void RC522_irq_init(void);
+
+/**
+ * @brief   A function to send a request to a nearby card and return without waiting. The EXTI1 interrupt
+ *          flags the RC522 IRQ edge, the RC522 timer raises it when no card answers. No other command may
+ *          be sent until RC522_request_irq_poll() stops returning RC522_REQUEST_PENDING.
+ *
+ * @param   reqMode Request mode.
+ *
+ * @return  true if the request was sent, false on an SPI failure.
+ */
+bool RC522_request_irq_start(uint8_t reqMode);
+
+/**
+ * @brief   A function to check the request started by RC522_request_irq_start(). Only register reads are
+ *          done once the IRQ edge has been seen or MFRC522_IRQ_TIMEOUT_MS has passed, otherwise it returns at once.
+ *
+ * @param   tagType Pointer to the tag type array, receives the ATQA.
+ *
+ * @return  RC522_REQUEST_PENDING while the answer is outstanding, then RC522_REQUEST_CARD or RC522_REQUEST_NO_CARD.
+ */
+RC522_request_state_t RC522_request_irq_poll(uint8_t *tagType);
+
+/**
+ * @brief   A function to set the completion deadline of an MFRC522 command.
+ *
+ * @param   command    MFRC522 command (PCD_TRANSCEIVE, PCD_AUTHENT, PCD_CALCCRC, ...)
+ *          timeout_us Deadline in microseconds
+ *
+ * @return  None.
+ */
+void RC522_set_command_timeout(uint8_t command, uint32_t timeout_us);
+
+/**
+ * @brief   A function to get the completion deadline and poll statistics of an MFRC522 command.
+ *
+ * @param   command MFRC522 command
+ *
+ * @return  Pointer to the timing record of the command.
+ */
+const RC522_command_timing_t* RC522_get_command_timing(uint8_t command);
+
 /**
  * @brief   A function to control the Chip Select (CS) pin of the RC522 module.
  *
@@ -97,6 +276,31 @@ uint8_t RC522_reg_read8(uint8_t reg);
  */
 void RC522_reg_write8(uint8_t reg, uint8_t data8);
 
+/**
+ * @brief   A function to write a block of bytes to the RC522 FIFO in a single SPI transaction.
+ *          Chip-select stays asserted and the FIFO address is sent only once. From MFRC522_DMA_MIN_BURST bytes
+ *          the transfer runs on the DMA and the core sleeps until the completion interrupt, which releases
+ *          chip-select.
+ *
+ * @param   data Pointer to the data to write
+ *          len  Number of bytes to write (at most MFRC522_FIFO_SIZE)
+ *
+ * @return  true if the SPI transfer completed, false on an SPI timeout or a DMA transfer error.
+ */
+bool RC522_fifo_write_burst(const uint8_t *data, uint8_t len);
+
+/**
+ * @brief   A function to read a block of bytes from the RC522 FIFO in a single SPI transaction. Long reads
+ *          run on the DMA as in RC522_fifo_write_burst().
+ *
+ * @param   data Pointer to the buffer receiving the data
+ *          len  Number of bytes to read (at most MFRC522_FIFO_SIZE)
+ *
+ * @return  true if the SPI transfer completed, false on an SPI timeout or a DMA transfer error. The buffer is
+ *          left untouched on failure.
+ */
+bool RC522_fifo_read_burst(uint8_t *data, uint8_t len);
+
 /**
  * @brief   A function to set specific bits in a register of the RC522 RFID/NFC module.
  *
@@ -117,6 +321,16 @@ void RC522_set_bit(uint8_t reg, uint8_t mask);
  */
 void RC522_clear_bit(uint8_t reg, uint8_t mask);
 
+/**
+ * @brief   A function to drop the shadow copies of the RC522 configuration registers so the next
+ *          read of each one goes to the device again.
+ *
+ * @param   None
+ *
+ * @return  None.
+ */
+void RC522_shadow_invalidate(void);
+
 /**
  * @brief   A function to reset the RC522 RFID/NFC module.
  *
@@ -137,16 +351,114 @@ void RC522_antenna_ON(void);
 
 /**
  * @brief   A function to check for the presence of a card and retrieves its Unique IDentifier (UID) if a card is detected.
+ *          Single, double and triple size UIDs are read completely.
  *
- * @param   id Pointer the card UID.
+ * @param   uid Pointer the card UID.
  *
  * @return  Card checking result.
  */
-bool RC522_check_card(uint8_t *id);
+bool RC522_check_card(RC522_uid_t *uid);
+
+/**
+ * @brief   A function to enumerate every card in the field in one pass. Each round sends a REQA, selects one
+ *          card through the anti-collision tree walk and halts it, so it no longer answers the next REQA.
+ *          The pass ends when no card answers or the list is full.
+ *
+ * @param   reqMode  Request of the first round, PICC_REQIDL skips cards halted by an earlier pass,
+ *                   PICC_REQALL wakes them up again
+ *          uids     Pointer to the array receiving the UIDs
+ *          maxCards Number of entries of the array
+ *
+ * @return  Number of cards found.
+ */
+uint8_t RC522_inventory(uint8_t reqMode, RC522_uid_t *uids, uint8_t maxCards);
+
+/**
+ * @brief   A function to set the hold-off window of the recently-seen UID cache.
+ *
+ * @param   hold_off_ms Time a card may go unseen before it is reported as removed
+ *
+ * @return  None.
+ */
+void RC522_set_hold_off(uint32_t hold_off_ms);
+
+/**
+ * @brief   A function to read the cards in the field and report only the changes since the last call.
+ *          A card held on the reader produces one RC522_EVENT_PRESENTED when it arrives and one
+ *          RC522_EVENT_REMOVED once it has not been seen for the hold-off window.
+ *
+ * @param   events    Pointer to the array receiving the events
+ *          maxEvents Number of entries of the array, MFRC522_EVENTS_MAX never drops an event
+ *
+ * @return  Number of events reported.
+ */
+uint8_t RC522_poll_events(RC522_event_t *events, uint8_t maxEvents);
+
+/**
+ * @brief   A function to check whether the reader is in use: a card reported by RC522_poll_events() has not been
+ *          reported removed yet, or the IRQ line has announced a card that is not read yet. Work that stalls
+ *          the core, such as a flash erase, should wait until it returns false.
+ *
+ * @param   None
+ *
+ * @return  True if a card is in the field or being read.
+ */
+bool RC522_field_busy(void);
+
+/**
+ * @brief   A function to put the RC522 into soft power-down. The field is switched off and the register contents are kept.
+ *
+ * @param   None
+ *
+ * @return  None.
+ */
+void RC522_power_down(void);
+
+/**
+ * @brief   A function to wake the RC522 from soft power-down and wait for its oscillator.
+ *
+ * @param   None
+ *
+ * @return  true if the RC522 left power-down before MFRC522_POWER_UP_TIMEOUT_US.
+ */
+bool RC522_power_up(void);
+
+/**
+ * @brief   A function to set the slot period of duty-cycled card detection.
+ *
+ * @param   interval_ms Slot period in milliseconds
+ *
+ * @return  None.
+ */
+void RC522_lpcd_set_interval(uint32_t interval_ms);
+
+/**
+ * @brief   A function to run one slot of duty-cycled card detection. Before the slot is due it returns at once
+ *          and the caller is free to sleep. Otherwise the RC522 is woken up, the field is given time to power
+ *          the cards and a REQA with a short timer checks for presence. Without an answer the RC522 goes back to
+ *          soft power-down and the next slot is scheduled one interval later. With an answer the cards in the
+ *          field are read as in RC522_inventory(), the RC522 is left powered and the next call runs a slot again.
+ *
+ * @param   uids     Pointer to the array receiving the UIDs
+ *          maxCards Number of entries of the array
+ *
+ * @return  Number of cards found.
+ */
+uint8_t RC522_lpcd_poll(RC522_uid_t *uids, uint8_t maxCards);
+
+/**
+ * @brief   A function to get the duty-cycled detection statistics with the current and latency estimates updated.
+ *
+ * @param   None
+ *
+ * @return  Pointer to the statistics.
+ */
+const RC522_lpcd_stats_t* RC522_lpcd_get_stats(void);
 
 /**
  * @brief   A function part of the process of making a request to a nearby RFID/NFC card using the RC522 module.
  * It initiates the communication and requests the card to respond, then checks the response to determine if a card has been detected.
+ * Colliding ATQAs of several cards count as a detected card.
  *
  * @param   reqMode Request mode.
  *          tagType Pointer to the tag type array.
@@ -170,13 +482,36 @@ bool RC522_to_card(uint8_t command, uint8_t *sendData, uint8_t sendLen,
 		uint8_t *backData, uint16_t *backLen);
 
 /**
- * @brief   A function of anti-collision anti-collision to detect and select a specific card when multiple cards are present in the reader's field.
+ * @brief   A function to get the ERROR register value latched by the last RC522_to_card() call.
+ *
+ * @param   None
+ *
+ * @return  ERROR register value, 0 if the last command completed without error.
+ */
+uint8_t RC522_get_last_error(void);
+
+/**
+ * @brief   A function of anti-collision to detect and select a specific card at one cascade level when multiple
+ *          cards are present in the reader's field. Bit collisions are resolved by following the 1 branch, so
+ *          exactly one card is selected without repeating the request.
  *
- * @param   serNum Pointer to the serial number array for anti-collision
+ * @param   selCmd Select command of the cascade level (PICC_ANTICOLL, PICC_SEL_CL2, PICC_SEL_CL3)
+ *          serNum Pointer to the 4 byte UID part of the level, including the cascade tag if any
+ *          sak    Pointer to the SAK returned by the card
  *
  * @return  Status of the anti-collision process.
  */
-bool RC522_anti_coll(uint8_t *serNum);
+bool RC522_anti_coll(uint8_t selCmd, uint8_t *serNum, uint8_t *sak);
+
+/**
+ * @brief   A function to run the cascade levels required to select one card and read its complete UID.
+ *          The card must have answered a REQA or WUPA first.
+ *
+ * @param   uid Pointer to the UID of the selected card
+ *
+ * @return  true if a card has been selected.
+ */
+bool RC522_select(RC522_uid_t *uid);
 
 /**
  * @brief   A function to halt communication with an RFID/NFC card using the RC522 module.
@@ -187,6 +522,70 @@ bool RC522_anti_coll(uint8_t *serNum);
  */
 void RC522_halt(void);
 
+/**
+ * @brief   A function to authenticate a MIFARE Classic sector. Crypto1 runs on the RC522 and stays enabled
+ *          for the following block accesses until RC522_stop_crypto1() is called.
+ *
+ * @param   authMode  PICC_AUTH_KEYA or PICC_AUTH_KEYB
+ *          blockAddr Any block of the sector to authenticate
+ *          key       Pointer to the 6 byte sector key
+ *          uid       Pointer to the UID of the selected card
+ *
+ * @return  true if the card accepted the key.
+ */
+bool RC522_auth(uint8_t authMode, uint8_t blockAddr, const uint8_t *key,
+		const RC522_uid_t *uid);
+
+/**
+ * @brief   A function to read a 16 byte block of an authenticated MIFARE Classic sector.
+ *
+ * @param   blockAddr Block address
+ *          data      Pointer to the 16 byte buffer receiving the block
+ *
+ * @return  true if the block was read and its CRC_A is valid.
+ */
+bool RC522_read_block(uint8_t blockAddr, uint8_t *data);
+
+/**
+ * @brief   A function to write a 16 byte block of an authenticated MIFARE Classic sector.
+ *
+ * @param   blockAddr Block address
+ *          data      Pointer to the 16 byte block to write
+ *
+ * @return  true if the card acknowledged both write phases.
+ */
+bool RC522_write_block(uint8_t blockAddr, const uint8_t *data);
+
+/**
+ * @brief   A function to end an authenticated session by switching Crypto1 off in the RC522.
+ *
+ * @param   None
+ *
+ * @return  None.
+ */
+void RC522_stop_crypto1(void);
+
+/**
+ * @brief   A function to calculate the ISO/IEC 14443-3 CRC_A of a frame on the MCU with a 256 entry table,
+ *          without a round trip to the RC522 coprocessor. The result matches RC522_calculate_CRC().
+ *
+ * @param   pIndata  Pointer to the input data
+ *          len      Length of the input data
+ *          pOutData Pointer to the 2 byte output, least significant byte first
+ *
+ * @return  None.
+ */
+void RC522_crc_a(const uint8_t *pIndata, uint8_t len, uint8_t *pOutData);
+
+/**
+ * @brief   A function to check RC522_crc_a() against the RC522 CRC coprocessor on a set of reference frames.
+ *
+ * @param   None
+ *
+ * @return  true if every software result is bit-exact with the coprocessor result.
+ */
+bool RC522_crc_self_test(void);
+
 /**
  * @brief   A function to calculate the CRC (Cyclic Redundancy Check) for a given set of input data using the RC522 RFID/NFC module.
  *
@@ -0,0 +1,93 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   rfid_trace.h
+* @brief  A file declaring the RC522 register access tracer. Every register access of the RFID path is
+*         recorded with its DWT cycle timestamp into a fixed RAM ring buffer, which can be dumped as text
+*         and decoded on the host (Simulator/trace_decode.c).
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 8, 2023
+* @revision 1.0
+*
+*/
+
+#ifndef __RFID_TRACE_H
+#define __RFID_TRACE_H
+
+#include <stdint.h>
+#include "rfid.h"
+
+#define RFID_TRACE_SIZE		256		// Entries in the ring buffer, a power of two (8 bytes each)
+
+/* Kinds of trace entries */
+#define RFID_TRACE_READ			0x01	// Register read over SPI
+#define RFID_TRACE_READ_SHADOW	0x02	// Register read served from the shadow copy
+#define RFID_TRACE_WRITE		0x03	// Register write over SPI
+#define RFID_TRACE_WRITE_SKIP	0x04	// Register write skipped, the shadow copy already holds the value
+#define RFID_TRACE_FIFO_READ	0x05	// FIFO burst read, value is the length
+#define RFID_TRACE_FIFO_WRITE	0x06	// FIFO burst write, value is the length
+#define RFID_TRACE_BEGIN		0x10	// Start of a driver call, reg is the call id
+#define RFID_TRACE_END			0x11	// End of a driver call, reg is the call id and value the result
+
+/* Driver calls marked in the trace */
+#define RFID_TRACE_ID_REQUEST	0x01	// RC522_request()
+#define RFID_TRACE_ID_ANTI_COLL	0x02	// RC522_anti_coll()
+#define RFID_TRACE_ID_HALT		0x03	// RC522_halt()
+
+/* One recorded event */
+typedef struct {
+	uint32_t cycles;	// DWT cycle counter
+	uint8_t type;		// RFID_TRACE_*
+	uint8_t reg;		// Register address or call id
+	uint8_t value;		// Value read or written, burst length or call result
+	uint8_t repeat;		// Further identical reads folded into this entry, cycles is the time of the last one
+} rfid_trace_entry_t;
+
+#ifdef MFRC522_TRACE_ENABLE
+#define RFID_TRACE(type, reg, value)	rfid_trace_record((type), (reg), (value))
+#else
+#define RFID_TRACE(type, reg, value)
+#endif
+
+/**
+ * @brief   A function to append an event to the trace ring buffer, the oldest entry is overwritten when it is full.
+ *          A run of identical status reads (a completion poll) takes two entries, the first read and the last one
+ *          with the repeat count.
+ *
+ * @param   type  Kind of event (RFID_TRACE_*)
+ *          reg   Register address or call id
+ *          value Value, length or result
+ *
+ * @return  None.
+ */
+void rfid_trace_record(uint8_t type, uint8_t reg, uint8_t value);
+
+/**
+ * @brief   A function to empty the trace ring buffer.
+ *
+ * @param   None
+ *
+ * @return  None.
+ */
+void rfid_trace_clear(void);
+
+/**
+ * @brief   A function to print the trace, oldest entry first. The dump starts with "TRACE <entries> <cycles per us>",
+ *          has one "<cycles> <type> <reg> <value> <repeat>" hex line per entry and ends with "END".
+ *
+ * @param   write Function printing a string, USART2_string_transmit on the target
+ *
+ * @return  None.
+ */
+void rfid_trace_dump(void (*write)(char *text));
+
+#endif /* __RFID_TRACE_H */
@@ -0,0 +1,103 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   scheduler.h
+* @brief  A file declaring the cooperative run-to-completion scheduler of the main loop. Periodic tasks are
+*         released on the SysTick millisecond base, each pass runs the most urgent released task to completion
+*         and the core sleeps with WFI when nothing is due. The DWT cycle counter times every run, so the
+*         worst case and average run time of each task show where the loop jitter comes from.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 16, 2023
+* @revision 1.0
+*
+*/
+
+#ifndef __SCHEDULER_H
+#define __SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SCHEDULER_MAX_TASKS		10
+#define SCHEDULER_BACKGROUND	0		// Period of a task run once per millisecond when no periodic task is due
+
+/* Run time accounting of a task */
+typedef struct {
+	const char *name;
+	uint32_t period_ms;		// Release period, SCHEDULER_BACKGROUND for a background task
+	uint8_t priority;		// 0 is the most urgent
+	uint32_t runs;			// Completed runs
+	uint32_t max_cycles;	// Longest run
+	uint64_t total_cycles;	// Sum of all runs, total_cycles / runs is the average
+	uint32_t late;			// Releases skipped because the previous one ran a whole period late
+} scheduler_task_stats_t;
+
+/**
+ * @brief   A function to add a task. Tasks of equal priority run in the order they were added.
+ *
+ * @param   name      Task name, for the statistics
+ *          run       Function run to completion at each release
+ *          period_ms Release period in milliseconds, SCHEDULER_BACKGROUND to run it when the loop is idle
+ *          priority  0 is the most urgent
+ *
+ * @return  Task number, -1 if the task table is full.
+ */
+int8_t scheduler_add(const char *name, void (*run)(void), uint32_t period_ms, uint8_t priority);
+
+/**
+ * @brief   A function to run the most urgent released task, or a background task when no periodic task is
+ *          due. Every background task runs at most once per millisecond, so once they have all had their turn
+ *          it returns without running anything until the next tick or the next release.
+ *
+ * @param   None
+ *
+ * @return  True if a task ran.
+ */
+bool scheduler_run_once(void);
+
+/**
+ * @brief   A function to run the tasks forever, sleeping until the next SysTick interrupt when no task ran.
+ *
+ * @param   None
+ *
+ * @return  None.
+ */
+void scheduler_run(void);
+
+/**
+ * @brief   A function to get the run time accounting of a task.
+ *
+ * @param   task Task number
+ *
+ * @return  Pointer to the statistics, NULL for an unknown task.
+ */
+const scheduler_task_stats_t* scheduler_get_stats(uint8_t task);
+
+/**
+ * @brief   A function to clear the run time accounting of every task.
+ *
+ * @param   None
+ *
+ * @return  None.
+ */
+void scheduler_clear_stats(void);
+
+/**
+ * @brief   A function to print one "<name> <period ms> <priority> <runs> <avg us> <max us> <late>" line per task.
+ *
+ * @param   write Function printing a string, USART2_string_transmit on the target
+ *
+ * @return  None.
+ */
+void scheduler_dump(void (*write)(char *text));
+
+#endif /* __SCHEDULER_H */
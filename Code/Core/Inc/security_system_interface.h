@@ -24,10 +24,58 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
-#include "security_system_interface.h"
+
+/* States of the access flow */
+typedef enum {
+	ACCESS_IDLE,			// Waiting for a card
+	ACCESS_CARD_READ,		// Cards tapped, checking them
+	ACCESS_PIN_ENTRY,		// Unknown card, waiting for the security password
+	ACCESS_ADMIN_ENROLL,	// Wrong security password, waiting for the admin password to add the card
+	ACCESS_RESULT			// Showing the decision
+} access_state_t;
+
+/**
+ * @brief   A function to load the cards enrolled by the admin from flash and build the card filter.
+ *
+ * @param   None
+ *
+ * @return  None.
+ */
+void security_system_init(void);
+
+/**
+ * @brief   A function to poll the RFID reader and check the cards tapped. It is the RFID task of the scheduler.
+ *
+ * @param   None
+ *
+ * @return  None.
+ */
+void access_poll_cards(void);
 
 /**
- * @brief   A function to check the access to the system based on the UID and passwords.
+ * @brief   A function to scan the keypad while a password is expected. It is the keypad task of the scheduler.
+ *
+ * @param   None
+ *
+ * @return  None.
+ */
+void access_poll_keypad(void);
+
+/**
+ * @brief   A function to handle the password timeout and the end of the decision display. It is the timer task
+ *          of the scheduler.
+ *
+ * @param   None
+ *
+ * @return  None.
+ */
+void access_update_timers(void);
+
+/**
+ * @brief   A function to check the access to the system based on the UID and passwords. It runs one step of
+ *          the access state machine and never waits: card taps, keys and timeouts move it from state to state.
+ *          It does the work of the RFID, keypad, timer and OLED tasks at once, for a main loop without the
+ *          scheduler.
  *
  * @param   None
  *
@@ -35,4 +83,13 @@
  */
 void check_access(void);
 
+/**
+ * @brief   A function to get the state of the access flow.
+ *
+ * @param   None
+ *
+ * @return  Current state.
+ */
+access_state_t access_get_state(void);
+
 #endif /* __SECURITY_SYSTEM_H */
@@ -0,0 +1,69 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   sha256.h
+* @brief  A file declaring a compact SHA-256 (FIPS 180-4). The message schedule is kept as a ring of 16 words
+*         so a context takes 104 bytes of RAM, and the round function is written so GCC emits single cycle ROR
+*         instructions on the Cortex-M4.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 17, 2023
+* @revision 1.0
+*
+*/
+
+#ifndef __SHA256_H
+#define __SHA256_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SHA256_BLOCK_SIZE	64
+#define SHA256_DIGEST_SIZE	32
+
+/* Hash in progress */
+typedef struct {
+	uint32_t state[8];
+	uint64_t length;					// Bytes hashed
+	uint8_t block[SHA256_BLOCK_SIZE];	// Bytes waiting for a full block
+} sha256_t;
+
+/**
+ * @brief   A function to start a hash.
+ *
+ * @param   ctx Pointer to the hash
+ *
+ * @return  None.
+ */
+void sha256_init(sha256_t *ctx);
+
+/**
+ * @brief   A function to add bytes to a hash.
+ *
+ * @param   ctx    Pointer to the hash
+ *          data   Pointer to the bytes
+ *          length Number of bytes
+ *
+ * @return  None.
+ */
+void sha256_update(sha256_t *ctx, const void *data, size_t length);
+
+/**
+ * @brief   A function to finish a hash. The context must be started again before it is reused.
+ *
+ * @param   ctx    Pointer to the hash
+ *          digest Array receiving the 32 byte digest
+ *
+ * @return  None.
+ */
+void sha256_final(sha256_t *ctx, uint8_t digest[SHA256_DIGEST_SIZE]);
+
+#endif /* __SHA256_H */
@@ -22,6 +22,16 @@
 #define __SPI_H
 
 #include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief   Completion callback for an asynchronous SPI transfer, called from the DMA interrupt.
+ *
+ * @param   status 0 on success, -1 on a DMA transfer error
+ *
+ * @return  None.
+ */
+typedef void (*spi_callback_t)(int8_t status);
 
 /**
  * @brief   A function to initialize the SPI.
@@ -32,6 +42,33 @@
  */
 void spi_init(void);
 
+/**
+ * @brief   A function to change the SPI clock by setting the SPI1 baud-rate divider at runtime.
+ *
+ * @param   divider fPCLK2 divider, a power of two from 2 to 256
+ *
+ * @return  0 on success, -1 if the divider is not supported.
+ */
+int8_t spi_set_clock_divider(uint16_t divider);
+
+/**
+ * @brief   A function to get the current SPI1 baud-rate divider.
+ *
+ * @param   None
+ *
+ * @return  fPCLK2 divider in use (2 to 256).
+ */
+uint16_t spi_get_clock_divider(void);
+
+/**
+ * @brief   A function to get the current SPI clock frequency.
+ *
+ * @param   None
+ *
+ * @return  SCK frequency in hertz derived from SystemCoreClock and the APB2 prescaler.
+ */
+uint32_t spi_get_clock_hz(void);
+
 /**
  * @brief   A function to transmit data over the SPI (Serial Peripheral Interface) bus.
  *
@@ -52,4 +89,50 @@ int8_t spi_transmit(uint8_t *data, uint32_t size);
  */
 int8_t spi_receive(uint8_t *data, uint32_t size);
 
+/**
+ * @brief   A function to exchange data over the SPI bus in full duplex. Every transmitted byte
+ *          clocks in one received byte, which is stored in the receive buffer.
+ *
+ * @param   tx   Pointer to the data to transmit, NULL to clock out 0x00 bytes
+ *          rx   Pointer to the receive buffer, NULL to discard the received bytes
+ *          size Number of bytes to exchange
+ *
+ * @return  Transfer status.
+ */
+int8_t spi_transfer(const uint8_t *tx, uint8_t *rx, uint32_t size);
+
+/**
+ * @brief   A function to get the number of SPI transactions issued since start-up.
+ *          Every call of spi_transmit(), spi_receive(), spi_transfer() and spi_transfer_async() counts once.
+ *
+ * @param   None
+ *
+ * @return  Transaction count.
+ */
+uint32_t spi_get_transaction_count(void);
+
+/**
+ * @brief   A function to start a full-duplex SPI transfer driven by DMA2 (stream 3 TX, stream 2 RX).
+ *          The call returns immediately and the callback runs once the last byte is received, or with -1
+ *          as soon as either stream reports a transfer error. Chip-select is left to the caller.
+ *
+ * @param   tx       Pointer to the data to transmit, NULL to clock out 0x00 bytes
+ *          rx       Pointer to the receive buffer, NULL to discard the received bytes
+ *          size     Number of bytes to exchange (1 to 65535)
+ *          callback Function called on completion, may be NULL
+ *
+ * @return  0 if the transfer was started, -1 if the engine is busy or the size is invalid.
+ */
+int8_t spi_transfer_async(const uint8_t *tx, uint8_t *rx, uint32_t size,
+		spi_callback_t callback);
+
+/**
+ * @brief   A function to check whether an asynchronous SPI transfer is still in progress.
+ *
+ * @param   None
+ *
+ * @return  true while the DMA transfer is running.
+ */
+bool spi_transfer_busy(void);
+
 #endif /* __SPI_H */
@@ -39,4 +39,23 @@ void voice_init(void);
  */
 void voice_check(void);
 
+/**
+ * @brief   A function to start the recorded message without waiting, voice_update() ends the trigger pulse.
+ *
+ * @param   None
+ *
+ * @return  None.
+ */
+void voice_start(void);
+
+/**
+ * @brief   A function to end the trigger pulse of the voice module once it is long enough, called from the
+ *          main loop.
+ *
+ * @param   None
+ *
+ * @return  None.
+ */
+void voice_update(void);
+
 #endif /* __VOICE_H_ */
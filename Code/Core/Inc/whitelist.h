@@ -0,0 +1,84 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   whitelist.h
+* @brief  A file declaring the site whitelist, the cards allowed by the firmware image. The table is generated
+*         from whitelist.csv into whitelist_table.c by "make -C Simulator whitelist". It is a minimal
+*         perfect hash: every card has its own slot, so a lookup is one hash and one compare. The table is
+*         const and stays in flash.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 11, 2023
+* @revision 1.0
+*
+*/
+
+#ifndef __WHITELIST_H
+#define __WHITELIST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "rfid.h"
+
+#define WHITELIST_BUCKET_SIZE	4		// Average cards per displacement bucket, 1 byte of flash per card
+
+/* A card in the whitelist */
+typedef struct {
+	uint8_t size;							// 4, 7 or 10 bytes
+	uint8_t uid[MFRC522_UID_MAX_SIZE];		// UID without cascade tags
+} whitelist_uid_t;
+
+/* A generated whitelist */
+typedef struct {
+	uint32_t count;						// Cards, also the number of slots
+	uint32_t buckets;					// Entries of displace
+	uint32_t salt;						// Hash seed picked by the generator
+	const uint32_t *displace;			// Displacement of every bucket, d0 << 16 | d1
+	const whitelist_uid_t *uids;		// Cards in slot order
+} whitelist_table_t;
+
+/* The whitelist compiled into the firmware */
+extern const whitelist_table_t whitelist;
+
+/**
+ * @brief   A function to hash a UID into the three values used to place it in a whitelist.
+ *
+ * @param   salt Hash seed
+ *          uid  Pointer to the UID bytes
+ *          size UID size
+ *          hash Bucket hash, first and second slot hash
+ *
+ * @return  None.
+ */
+void whitelist_hash(uint32_t salt, const uint8_t *uid, uint8_t size, uint32_t hash[3]);
+
+/**
+ * @brief   A function to get the slot of a UID from its hash, the slot is only meaningful for cards in the table.
+ *
+ * @param   table Pointer to the whitelist
+ *          hash  Hash of the UID from whitelist_hash()
+ *
+ * @return  Slot number.
+ */
+uint32_t whitelist_slot(const whitelist_table_t *table, const uint32_t hash[3]);
+
+/**
+ * @brief   A function to look a card up in a whitelist.
+ *
+ * @param   table Pointer to the whitelist
+ *          uid   Pointer to the UID bytes
+ *          size  UID size
+ *
+ * @return  True if the card is in the whitelist.
+ */
+bool whitelist_find(const whitelist_table_t *table, const uint8_t *uid, uint8_t size);
+
+#endif /* __WHITELIST_H */
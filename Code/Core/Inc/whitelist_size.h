@@ -0,0 +1,10 @@
+/*
+ * Generated by Simulator/whitelist_gen from whitelist.csv, do not edit.
+ */
+
+#ifndef __WHITELIST_SIZE_H
+#define __WHITELIST_SIZE_H
+
+#define WHITELIST_CARDS	5		// Cards of the whitelist compiled into the firmware
+
+#endif /* __WHITELIST_SIZE_H */
@@ -22,6 +22,10 @@
 
 #include "UART.h"
 
+static volatile char USART2_tx_buffer[USART2_TX_SIZE];
+static volatile uint32_t USART2_tx_head = 0;	// Written only by USART2_transmit()
+static volatile uint32_t USART2_tx_tail = 0;	// Written only by USART2_IRQHandler()
+
 void USART2_init(void) {
 	RCC->APB1ENR |= (1 << 17);
 	RCC->AHB1ENR |= (1 << 0);
@@ -34,16 +38,40 @@ void USART2_init(void) {
 	USART2->BRR = 0X0683;  				//9600 Baud rate 16 MHz
 
 	USART2->CR1 = USART_CR1_TE | USART_CR1_RE | USART_CR1_UE;
+	NVIC_EnableIRQ(USART2_IRQn);		// TX empty interrupt sends the buffered characters
 
 }
 
 char USART2_transmit(char input) {
-	while (!(USART2->SR & USART_SR_TXE))
-		;								// Wait for transmit
-	USART2->DR = input;
+	uint32_t head = USART2_tx_head;
+
+	while (head - USART2_tx_tail >= USART2_TX_SIZE)
+		;								// Wait for room in the transmit buffer
+	USART2_tx_buffer[head & (USART2_TX_SIZE - 1)] = input;
+	USART2_tx_head = head + 1;
+	USART2->CR1 |= USART_CR1_TXEIE;		// The interrupt clears it once the buffer is empty
 	return input;
 }
 
+uint32_t USART2_tx_free(void) {
+	return USART2_TX_SIZE - (USART2_tx_head - USART2_tx_tail);
+}
+
+// Function to send the next buffered character each time the data register is empty
+void USART2_IRQHandler(void) {
+	uint32_t tail = USART2_tx_tail;
+
+	if (!(USART2->SR & USART_SR_TXE) || !(USART2->CR1 & USART_CR1_TXEIE)) {
+		return;
+	}
+	if (tail == USART2_tx_head) {
+		USART2->CR1 &= ~USART_CR1_TXEIE;
+		return;
+	}
+	USART2->DR = USART2_tx_buffer[tail & (USART2_TX_SIZE - 1)];
+	USART2_tx_tail = tail + 1;
+}
+
 char USART2_receive(void) {
 	while (!(USART2->SR & USART_SR_RXNE))
 		;								// Wait for receive
@@ -51,6 +79,10 @@ char USART2_receive(void) {
 
 }
 
+int USART2_data_available(void) {
+	return (USART2->SR & USART_SR_RXNE) != 0;
+}
+
 void USART2_string_transmit(char *text) {
 	while (*text)
 		USART2_transmit(*text++);		// Transmit character by character
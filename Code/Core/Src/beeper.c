@@ -21,6 +21,10 @@
 #include "beeper.h"
 #include "delay.h"
 
+static uint32_t beeper_start_ms;
+static uint32_t beeper_length_ms;
+static uint8_t beeper_on = 0;
+
 void beeper_init(void) {
 	/* Enable the AHB clock for GPIO port D */
 	SET_BIT(RCC->AHB1ENR, RCC_AHB1ENR_GPIODEN);
@@ -39,3 +43,19 @@ void beeper_enable(void) {
 	/* Turn OFF the Buzzer */
 	GPIOD->BSRR |= GPIO_BSRR_BR2;
 }
+
+void beeper_start(uint32_t ms) {
+	/* Turn ON the Buzzer, beeper_update() turns it off */
+	GPIOD->BSRR |= GPIO_BSRR_BS2;
+	beeper_start_ms = millis();
+	beeper_length_ms = ms;
+	beeper_on = 1;
+}
+
+void beeper_update(void) {
+	/* Turn OFF the Buzzer once the beep is over */
+	if (beeper_on && (millis() - beeper_start_ms >= beeper_length_ms)) {
+		GPIOD->BSRR |= GPIO_BSRR_BR2;
+		beeper_on = 0;
+	}
+}
@@ -0,0 +1,92 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   bloom_filter.c
+* @brief  A file defining the Bloom filter over card UIDs. The k bit positions come from one UID hash by double
+*         hashing, bit i = h1 + i * h2.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 12, 2023
+* @revision 1.0
+*
+*/
+
+#include <string.h>
+#include "bloom_filter.h"
+
+// Function to hash a UID (FNV-1a) into the two values of the double hashing, h2 is odd to reach every bit
+static void bloom_filter_hash(const uint8_t *uid, uint8_t size, uint32_t *h1, uint32_t *h2) {
+	uint32_t h = (2166136261U ^ size) * 16777619U;
+	uint8_t i;
+
+	for (i = 0; i < size; i++) {
+		h = (h ^ uid[i]) * 16777619U;
+	}
+	// MurmurHash3 finalizer, FNV-1a alone leaves the low bits poorly mixed
+	h ^= h >> 16;
+	h *= 0x85EBCA6BU;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35U;
+	h ^= h >> 16;
+	*h1 = h;
+	*h2 = ((h >> 16) | (h << 16)) | 1;
+}
+
+// Function to set up an empty filter
+bool bloom_filter_init(bloom_filter_t *filter, uint32_t *storage, uint32_t size, uint8_t hashes) {
+	if ((size < 32) || (size & (size - 1)) || (hashes == 0)) {
+		return false;
+	}
+
+	filter->bits = storage;
+	filter->size = size;
+	filter->hashes = hashes;
+	bloom_filter_clear(filter);
+	return true;
+}
+
+// Function to remove every card
+void bloom_filter_clear(bloom_filter_t *filter) {
+	memset(filter->bits, 0, filter->size / 8);
+	filter->cards = 0;
+}
+
+// Function to add a card
+void bloom_filter_add(bloom_filter_t *filter, const uint8_t *uid, uint8_t size) {
+	uint32_t h1;
+	uint32_t h2;
+	uint32_t bit;
+	uint8_t i;
+
+	bloom_filter_hash(uid, size, &h1, &h2);
+	for (i = 0; i < filter->hashes; i++) {
+		bit = (h1 + i * h2) & (filter->size - 1);
+		filter->bits[bit >> 5] |= 1U << (bit & 31);
+	}
+	filter->cards++;
+}
+
+// Function to check a card, it stops at the first clear bit so an unknown card usually costs one or two reads
+bool bloom_filter_may_contain(const bloom_filter_t *filter, const uint8_t *uid, uint8_t size) {
+	uint32_t h1;
+	uint32_t h2;
+	uint32_t bit;
+	uint8_t i;
+
+	bloom_filter_hash(uid, size, &h1, &h2);
+	for (i = 0; i < filter->hashes; i++) {
+		bit = (h1 + i * h2) & (filter->size - 1);
+		if (!(filter->bits[bit >> 5] & (1U << (bit & 31)))) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,283 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   credential_store.c
+* @brief  A file defining the persistent store of the cards enrolled by the admin.
+*
+*         Sector layout, in 12 byte slots:
+*           slot 0   header: magic, generation, state (erased while the sector is being filled)
+*           slot 1.. records: op << 4 | size, UID padded with 0xFF, check byte; programmed as three words,
+*                    the word holding the check byte last
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 13, 2023
+* @revision 1.0
+*
+*/
+
+#include <string.h>
+#include "credential_store.h"
+#include "credentials.h"
+#include "crc8.h"
+#include "flash.h"
+#include "rfid.h"
+
+#define STORE_MAGIC			0x43524544U		// "CRED"
+#define STORE_ACTIVE		0x00000000U		// State word of a complete sector
+#define STORE_OP_ADD		0x0A
+#define STORE_OP_REMOVE		0x05
+#define STORE_WORDS			(CREDENTIAL_STORE_RECORD_SIZE / 4)
+
+/* One log record */
+typedef union {
+	struct {
+		uint8_t op_size;
+		uint8_t uid[MFRC522_UID_MAX_SIZE];
+		uint8_t check;
+	} r;
+	uint32_t words[STORE_WORDS];
+} store_record_t;
+
+static const uint8_t store_sectors[2] = { CREDENTIAL_STORE_SECTOR_A, CREDENTIAL_STORE_SECTOR_B };
+static uint8_t store_active = 0;		// Index in store_sectors
+static uint32_t store_slots = 0;		// Slots in a sector
+static uint32_t store_next = 0;			// Next free slot of the active sector
+static bool store_copy_failed;
+static uint8_t store_copy_sector;
+static uint32_t store_copy_next;
+static credential_store_stats_t store_stats;
+
+// Function to bring the counters of the statistics up to date
+static void store_update_stats(void) {
+	store_stats.records = store_next - 1;
+	store_stats.free = store_slots - store_next;
+	store_stats.cards = credentials_get_stats()->count;
+}
+
+// Function to get the address of a slot of a sector
+static uintptr_t store_slot_address(uint8_t sector, uint32_t slot) {
+	return flash_sector_address(sector) + slot * CREDENTIAL_STORE_RECORD_SIZE;
+}
+
+// Function to compute the check byte of a record (CRC-8, polynomial 0x07), 0xFF is never used
+static uint8_t store_check(const store_record_t *record) {
+	uint8_t crc = crc8((const uint8_t*) record, CREDENTIAL_STORE_RECORD_SIZE - 1);
+
+	return (crc == 0xFF) ? 0x00 : crc;
+}
+
+// Function to program a record, the word holding the check byte goes last and commits it
+static bool store_write_record(uint8_t sector, uint32_t slot, uint8_t op, const uint8_t *uid, uint8_t size) {
+	store_record_t record;
+	uintptr_t address = store_slot_address(sector, slot);
+	uint8_t w;
+
+	memset(&record, 0xFF, sizeof(record));
+	record.r.op_size = (op << 4) | size;
+	memcpy(record.r.uid, uid, size);
+	record.r.check = store_check(&record);
+
+	for (w = 0; w < STORE_WORDS; w++) {
+		if (flash_program_word(address + 4 * w, record.words[w]) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Function to check whether a sector holds a complete log, and get its generation
+static bool store_sector_valid(uint8_t sector, uint32_t *generation) {
+	const uint32_t *header = (const uint32_t*) flash_sector_address(sector);
+
+	*generation = header[1];
+	return (header[0] == STORE_MAGIC) && (header[2] == STORE_ACTIVE);
+}
+
+// Function to erase a sector and start a log with the given generation, the state word stays erased
+static bool store_format(uint8_t sector, uint32_t generation) {
+	uintptr_t header = flash_sector_address(sector);
+
+	return (flash_erase_sector(sector) == 0) && (flash_program_word(header, STORE_MAGIC) == 0)
+			&& (flash_program_word(header + 4, generation) == 0);
+}
+
+// Function to copy one live card into the sector being filled
+static void store_copy_card(const uint8_t *uid, uint8_t size) {
+	if (!store_copy_failed) {
+		store_copy_failed = !store_write_record(store_copy_sector, store_copy_next, STORE_OP_ADD, uid, size);
+		store_copy_next++;
+	}
+}
+
+// Function to move the live cards to the other sector and make it the active one
+static bool store_compact(void) {
+	uint8_t other = store_active ^ 1;
+
+	if (credentials_get_stats()->count >= store_slots - 1) {
+		return false;
+	}
+
+	store_copy_sector = store_sectors[other];
+	store_copy_next = 1;
+	store_copy_failed = !store_format(store_copy_sector, store_stats.generation + 1);
+	credentials_for_each(store_copy_card);
+
+	// Until the state word is written a power loss falls back to the current sector
+	if (store_copy_failed
+			|| (flash_program_word(flash_sector_address(store_copy_sector) + 8, STORE_ACTIVE) != 0)) {
+		return false;
+	}
+
+	store_active = other;
+	store_next = store_copy_next;
+	store_stats.generation++;
+	return true;
+}
+
+// Function to append a record to the log, compacting it first when the active sector is full, which only
+// happens if the idle task had no chance to run credential_store_prepare()
+static bool store_append(uint8_t op, const uint8_t *uid, uint8_t size) {
+	bool status;
+
+	if ((store_next >= store_slots) && !store_compact()) {
+		return false;
+	}
+
+	// The slot is used even if the write fails, a half programmed slot is skipped at the next mount
+	status = store_write_record(store_sectors[store_active], store_next, op, uid, size);
+	store_next++;
+	store_update_stats();
+	return status;
+}
+
+// Function to replay the log of the active sector into the RAM index
+static bool store_replay(void) {
+	const store_record_t *record;
+	uint8_t sector = store_sectors[store_active];
+	uint8_t size;
+	uint8_t op;
+	uint32_t slot;
+	uint8_t w;
+	bool erased;
+	bool status = true;
+
+	credentials_clear();
+	for (slot = 1; slot < store_slots; slot++) {
+		record = (const store_record_t*) store_slot_address(sector, slot);
+
+		erased = true;
+		for (w = 0; w < STORE_WORDS; w++) {
+			erased &= (record->words[w] == FLASH_ERASED_WORD);
+		}
+		if (erased) {
+			break;
+		}
+
+		op = record->r.op_size >> 4;
+		size = record->r.op_size & 0x0F;
+		if (record->words[STORE_WORDS - 1] == FLASH_ERASED_WORD) {
+			store_stats.torn++;
+		} else if (record->r.check != store_check(record)) {
+			store_stats.corrupt++;
+		} else if (op == STORE_OP_ADD) {
+			status &= credentials_add(record->r.uid, size);
+		} else if (op == STORE_OP_REMOVE) {
+			credentials_remove(record->r.uid, size);
+		} else {
+			store_stats.corrupt++;
+		}
+	}
+
+	store_next = slot;
+	store_update_stats();
+	return status;
+}
+
+// Function to mount the store
+bool credential_store_init(void) {
+	uint32_t generation[2];
+	bool valid[2];
+	uint8_t s;
+
+	memset(&store_stats, 0, sizeof(store_stats));
+	store_slots = flash_sector_size(CREDENTIAL_STORE_SECTOR_A) / CREDENTIAL_STORE_RECORD_SIZE;
+
+	for (s = 0; s < 2; s++) {
+		valid[s] = store_sector_valid(store_sectors[s], &generation[s]);
+	}
+
+	if (!valid[0] && !valid[1]) {
+		// First boot, or both sectors damaged: start an empty log
+		store_active = 0;
+		store_stats.generation = 1;
+		if (!store_format(store_sectors[0], 1)
+				|| (flash_program_word(flash_sector_address(store_sectors[0]) + 8, STORE_ACTIVE) != 0)) {
+			return false;
+		}
+	} else {
+		store_active = (valid[1] && (!valid[0] || (int32_t) (generation[1] - generation[0]) > 0)) ? 1 : 0;
+		store_stats.generation = generation[store_active];
+	}
+
+	return store_replay();
+}
+
+// Function to enroll a card
+bool credential_store_add(const uint8_t *uid, uint8_t size) {
+	const credentials_stats_t *index = credentials_get_stats();
+
+	if (credentials_find(uid, size)) {
+		return true;
+	}
+	if (((size != 4) && (size != 7) && (size != 10)) || (index->count >= index->capacity)) {
+		return false;
+	}
+
+	if (!store_append(STORE_OP_ADD, uid, size)) {
+		return false;
+	}
+	credentials_add(uid, size);
+	store_stats.cards++;
+	return true;
+}
+
+// Function to withdraw a card
+bool credential_store_remove(const uint8_t *uid, uint8_t size) {
+	if (!credentials_find(uid, size)) {
+		return false;
+	}
+
+	if (!store_append(STORE_OP_REMOVE, uid, size)) {
+		return false;
+	}
+	credentials_remove(uid, size);
+	store_stats.cards--;
+	return true;
+}
+
+// Function to move the live cards to the other sector before the active one is full
+bool credential_store_prepare(void) {
+	bool status;
+
+	// Not when the live cards alone leave fewer spare slots, the task would compact at every run
+	if ((store_slots - store_next >= CREDENTIAL_STORE_SPARE_SLOTS)
+			|| (credentials_get_stats()->count + 1 + CREDENTIAL_STORE_SPARE_SLOTS > store_slots)) {
+		return false;
+	}
+	status = store_compact();
+	store_update_stats();
+	return status;
+}
+
+// Function to get the state of the store
+const credential_store_stats_t* credential_store_get_stats(void) {
+	return &store_stats;
+}
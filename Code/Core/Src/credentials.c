@@ -0,0 +1,203 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   credentials.c
+* @brief  A file defining the table of cards allowed through the door.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 10, 2023
+* @revision 1.0
+*
+*/
+
+#include <string.h>
+#include "credentials.h"
+
+#if (CREDENTIALS_CAPACITY & (CREDENTIALS_CAPACITY - 1)) != 0
+#error "CREDENTIALS_CAPACITY must be a power of two"
+#endif
+
+#if CREDENTIALS_MAX_CARDS >= POOL_NONE
+#error "CREDENTIALS_CAPACITY is too large for the record pool"
+#endif
+
+#if (CREDENTIALS_CAPACITY * 2 + CREDENTIALS_MAX_CARDS * (1 + MFRC522_UID_MAX_SIZE) + CREDENTIALS_MAX_CARDS / 8) \
+		> CREDENTIALS_RAM_BUDGET
+#error "CREDENTIALS_CAPACITY does not fit in CREDENTIALS_RAM_BUDGET"
+#endif
+
+#define CREDENTIALS_MASK	(CREDENTIALS_CAPACITY - 1)
+#define CREDENTIALS_EMPTY	0		// Slot value of an empty slot, the others hold a pool block + 1
+
+/* One card record */
+typedef struct {
+	uint8_t size;
+	uint8_t uid[MFRC522_UID_MAX_SIZE];
+} credentials_record_t;
+
+static uint16_t credentials_table[CREDENTIALS_CAPACITY];
+static credentials_record_t credentials_records[CREDENTIALS_MAX_CARDS];
+static uint32_t credentials_used[POOL_USED_WORDS(CREDENTIALS_MAX_CARDS)];
+static pool_t credentials_pool = POOL_INIT(credentials_records, credentials_used);
+static credentials_stats_t credentials_stats = { 0, CREDENTIALS_MAX_CARDS, 0, 0 };
+
+// Function to hash a UID (FNV-1a), the size takes part so a 4 byte UID never matches the start of a longer one
+static uint32_t credentials_hash(const uint8_t *uid, uint8_t size) {
+	uint32_t hash = 2166136261U ^ size;
+	uint8_t i;
+
+	for (i = 0; i < size; i++) {
+		hash = (hash ^ uid[i]) * 16777619U;
+	}
+	return hash;
+}
+
+// Function to get the record of a used slot
+static const credentials_record_t* credentials_record(uint32_t slot) {
+	return &credentials_records[credentials_table[slot] - 1];
+}
+
+// Function to check that a UID size is one of the ISO 14443A sizes
+static bool credentials_size_valid(uint8_t size) {
+	return (size == 4) || (size == 7) || (size == 10);
+}
+
+// Function to get the slot holding a UID, or the empty slot ending its probe sequence
+static uint32_t credentials_slot(const uint8_t *uid, uint8_t size, bool *found, uint32_t *probes) {
+	uint32_t slot = credentials_hash(uid, size) & CREDENTIALS_MASK;
+	const credentials_record_t *entry;
+
+	// The load factor limit guarantees an empty slot, so the loop ends
+	for (;;) {
+		(*probes)++;
+		if (credentials_table[slot] == CREDENTIALS_EMPTY) {
+			*found = false;
+			return slot;
+		}
+		entry = credentials_record(slot);
+		if ((entry->size == size) && !memcmp(entry->uid, uid, size)) {
+			*found = true;
+			return slot;
+		}
+		slot = (slot + 1) & CREDENTIALS_MASK;
+	}
+}
+
+// Function to remove every card
+void credentials_clear(void) {
+	memset(credentials_table, CREDENTIALS_EMPTY, sizeof(credentials_table));
+	pool_reset(&credentials_pool);
+	credentials_stats.count = 0;
+	credentials_stats.lookups = 0;
+	credentials_stats.probes = 0;
+}
+
+// Function to add a card
+bool credentials_add(const uint8_t *uid, uint8_t size) {
+	credentials_record_t *record;
+	bool found;
+	uint32_t slot;
+	uint32_t probes = 0;
+	uint16_t block;
+
+	if (!credentials_size_valid(size)) {
+		return false;
+	}
+
+	slot = credentials_slot(uid, size, &found, &probes);
+	if (found) {
+		return true;
+	}
+	// The pool holds CREDENTIALS_MAX_CARDS records, so it enforces the load factor limit
+	block = pool_alloc(&credentials_pool);
+	if (block == POOL_NONE) {
+		return false;
+	}
+
+	record = &credentials_records[block];
+	record->size = size;
+	memcpy(record->uid, uid, size);
+	credentials_table[slot] = block + 1;
+	credentials_stats.count++;
+	return true;
+}
+
+// Function to remove a card, the following cards of the cluster move back so no tombstone is needed
+bool credentials_remove(const uint8_t *uid, uint8_t size) {
+	bool found;
+	uint32_t hole;
+	uint32_t slot;
+	uint32_t home;
+	uint32_t probes = 0;
+
+	if (!credentials_size_valid(size)) {
+		return false;
+	}
+
+	hole = credentials_slot(uid, size, &found, &probes);
+	if (!found) {
+		return false;
+	}
+	pool_free(&credentials_pool, credentials_table[hole] - 1);
+
+	// Only the 2 byte slots move, the records stay where they are in the pool
+	slot = hole;
+	for (;;) {
+		slot = (slot + 1) & CREDENTIALS_MASK;
+		if (credentials_table[slot] == CREDENTIALS_EMPTY) {
+			break;
+		}
+		// A card can fill the hole if its home slot is not between the hole and its current slot
+		home = credentials_hash(credentials_record(slot)->uid, credentials_record(slot)->size) & CREDENTIALS_MASK;
+		if (((slot - home) & CREDENTIALS_MASK) >= ((slot - hole) & CREDENTIALS_MASK)) {
+			credentials_table[hole] = credentials_table[slot];
+			hole = slot;
+		}
+	}
+
+	credentials_table[hole] = CREDENTIALS_EMPTY;
+	credentials_stats.count--;
+	return true;
+}
+
+// Function to look a card up
+bool credentials_find(const uint8_t *uid, uint8_t size) {
+	bool found;
+
+	credentials_stats.lookups++;
+	if (!credentials_size_valid(size)) {
+		return false;
+	}
+
+	credentials_slot(uid, size, &found, &credentials_stats.probes);
+	return found;
+}
+
+// Function to visit every card
+void credentials_for_each(void (*callback)(const uint8_t *uid, uint8_t size)) {
+	uint32_t slot;
+
+	for (slot = 0; slot < CREDENTIALS_CAPACITY; slot++) {
+		if (credentials_table[slot] != CREDENTIALS_EMPTY) {
+			callback(credentials_record(slot)->uid, credentials_record(slot)->size);
+		}
+	}
+}
+
+// Function to get the usage of the table
+const credentials_stats_t* credentials_get_stats(void) {
+	return &credentials_stats;
+}
+
+// Function to get the occupancy of the record pool
+const pool_stats_t* credentials_get_pool_stats(void) {
+	return &credentials_pool.stats;
+}
@@ -0,0 +1,102 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   debug_log.c
+* @brief  A file defining the deferred debug log.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 9, 2023
+* @revision 1.0
+*
+*/
+
+#include <stdio.h>
+#include "debug_log.h"
+#include "delay.h"
+
+static const char *const debug_log_format[DEBUG_LOG_COUNT] = {
+	[DEBUG_LOG_RC522_RX4] = "RC522 rx %08lx",
+	[DEBUG_LOG_RC522_ERROR] = "RC522 error %02lx, command %02lx",
+	[DEBUG_LOG_RC522_CRC_SELF_TEST] = "CRC_A self test failed",
+	[DEBUG_LOG_SPI_TXE_TIMEOUT] = "SPI TXE timed out at byte %lu of %lu",
+	[DEBUG_LOG_SPI_RXNE_TIMEOUT] = "SPI RXNE timed out at byte %lu of %lu",
+	[DEBUG_LOG_SPI_BSY_TIMEOUT] = "SPI BSY timed out at byte %lu of %lu",
+	[DEBUG_LOG_CREDENTIAL_STORE_MOUNT] = "Credential store mount failed, %lu cards loaded",
+	[DEBUG_LOG_JOURNAL_MOUNT] = "Access journal mount failed, %lu events found",
+	[DEBUG_LOG_CARD_FILTER_LOAD] = "Card filter overloaded, %lu cards at %lu bits per card",
+};
+
+static debug_log_entry_t debug_log_buffer[DEBUG_LOG_SIZE];
+static volatile uint32_t debug_log_head = 0;	// Written only by debug_log()
+static volatile uint32_t debug_log_tail = 0;	// Written only by debug_log_flush()
+static uint32_t debug_log_dropped_count = 0;
+static uint32_t debug_log_dropped_reported = 0;
+
+// Function to record an event id and its arguments
+void debug_log(debug_log_id_t id, uint32_t a, uint16_t b) {
+	uint32_t head = debug_log_head;
+	debug_log_entry_t *entry;
+
+	if (head - debug_log_tail >= DEBUG_LOG_SIZE) {
+		debug_log_dropped_count++;
+		return;
+	}
+
+	entry = &debug_log_buffer[head & (DEBUG_LOG_SIZE - 1)];
+	entry->ms = millis();
+	entry->id = id;
+	entry->b = b;
+	entry->a = a;
+
+	// The entry must be complete before the consumer can see it
+	__asm volatile ("" ::: "memory");
+	debug_log_head = head + 1;
+}
+
+// Function to format the oldest recorded events
+uint8_t debug_log_flush(void (*write)(char *text), uint8_t max) {
+	char line[DEBUG_LOG_LINE_SIZE];
+	uint32_t tail = debug_log_tail;
+	uint8_t printed = 0;
+
+	if (debug_log_dropped_count != debug_log_dropped_reported) {
+		sprintf(line, "%lu log entries dropped\r\n",
+				(unsigned long) (debug_log_dropped_count - debug_log_dropped_reported));
+		debug_log_dropped_reported = debug_log_dropped_count;
+		write(line);
+	}
+
+	while ((printed < max) && (tail != debug_log_head)) {
+		const debug_log_entry_t *entry = &debug_log_buffer[tail & (DEBUG_LOG_SIZE - 1)];
+		int n = sprintf(line, "[%lu] ", (unsigned long) entry->ms);
+
+		if (entry->id < DEBUG_LOG_COUNT) {
+			n += sprintf(&line[n], debug_log_format[entry->id], (unsigned long) entry->a,
+					(unsigned long) entry->b);
+		} else {
+			n += sprintf(&line[n], "event %u", entry->id);
+		}
+		sprintf(&line[n], "\r\n");
+
+		// The slot may be reused once the tail moves past it
+		__asm volatile ("" ::: "memory");
+		debug_log_tail = ++tail;
+		write(line);
+		printed++;
+	}
+
+	return printed;
+}
+
+// Function to get the number of dropped events
+uint32_t debug_log_dropped(void) {
+	return debug_log_dropped_count;
+}
@@ -22,6 +22,7 @@
 #include "delay.h"
 
 volatile uint32_t ms, rms;
+static uint32_t core_hz = 16000000;
 
 void systick_init_ms(uint32_t freq) {
 	__disable_irq();
@@ -29,6 +30,24 @@ void systick_init_ms(uint32_t freq) {
 	SysTick->VAL = 0;
 	SysTick->CTRL = 7; //0b00000111;
 	__enable_irq();
+
+	// Enable the DWT cycle counter as the sub-millisecond time base
+	core_hz = freq;
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+uint32_t cycles(void) {
+	return DWT->CYCCNT;
+}
+
+uint32_t cycles_from_us(uint32_t us) {
+	return us * (core_hz / 1000000);
+}
+
+uint32_t cycles_to_us(uint32_t count) {
+	return count / (core_hz / 1000000);
 }
 
 uint32_t millis(void) {
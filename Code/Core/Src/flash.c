@@ -0,0 +1,109 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   flash.c
+* @brief  A file defining the APIs to erase and program the internal flash of the STM32F411.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 13, 2023
+* @revision 1.0
+*
+*/
+
+#include "flash.h"
+#include "stm32f4xx.h"
+
+#define FLASH_KEY_1		0x45670123U
+#define FLASH_KEY_2		0xCDEF89ABU
+#define FLASH_SR_ERRORS	(FLASH_SR_WRPERR | FLASH_SR_PGAERR | FLASH_SR_PGPERR | FLASH_SR_PGSERR)
+
+static const uint32_t flash_sector_kb[FLASH_SECTORS] = { 16, 16, 16, 16, 64, 128, 128, 128 };
+
+// Function to get the address of a sector
+uintptr_t flash_sector_address(uint8_t sector) {
+	uintptr_t address = FLASH_BASE;
+	uint8_t s;
+
+	for (s = 0; (s < sector) && (s < FLASH_SECTORS); s++) {
+		address += flash_sector_kb[s] * 1024;
+	}
+	return address;
+}
+
+// Function to get the size of a sector
+uint32_t flash_sector_size(uint8_t sector) {
+	return (sector < FLASH_SECTORS) ? flash_sector_kb[sector] * 1024 : 0;
+}
+
+// Function to wait for the end of a flash operation and collect its errors
+static int8_t flash_wait(void) {
+	uint32_t sr;
+
+	while (FLASH->SR & FLASH_SR_BSY) {
+	}
+
+	sr = FLASH->SR;
+	FLASH->SR = FLASH_SR_ERRORS | FLASH_SR_EOP;	// Write 1 to clear
+	return (sr & FLASH_SR_ERRORS) ? -1 : 0;
+}
+
+// Function to unlock the flash control register
+static void flash_unlock(void) {
+	if (FLASH->CR & FLASH_CR_LOCK) {
+		FLASH->KEYR = FLASH_KEY_1;
+		FLASH->KEYR = FLASH_KEY_2;
+	}
+}
+
+// Function to erase a sector
+int8_t flash_erase_sector(uint8_t sector) {
+	int8_t status;
+
+	if (sector >= FLASH_SECTORS) {
+		return -1;
+	}
+
+	flash_wait();
+	flash_unlock();
+
+	// 32-bit parallelism, valid from 2.7 V
+	FLASH->CR = FLASH_CR_PSIZE_1 | FLASH_CR_SER | (sector << FLASH_CR_SNB_Pos);
+	FLASH->CR |= FLASH_CR_STRT;
+	status = flash_wait();
+	FLASH->CR = FLASH_CR_LOCK;
+
+	// The data cache may still hold the old contents of the sector
+	FLASH->ACR &= ~FLASH_ACR_DCEN;
+	FLASH->ACR |= FLASH_ACR_DCRST;
+	FLASH->ACR &= ~FLASH_ACR_DCRST;
+	FLASH->ACR |= FLASH_ACR_DCEN;
+
+	return status;
+}
+
+// Function to program a word
+int8_t flash_program_word(uintptr_t address, uint32_t data) {
+	int8_t status;
+
+	if (address & 0x03) {
+		return -1;
+	}
+
+	flash_wait();
+	flash_unlock();
+
+	FLASH->CR = FLASH_CR_PSIZE_1 | FLASH_CR_PG;
+	*(volatile uint32_t*) address = data;
+	status = flash_wait();
+	FLASH->CR = FLASH_CR_LOCK;
+
+	return status;
+}
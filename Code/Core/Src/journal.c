@@ -0,0 +1,399 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   journal.c
+* @brief  A file defining the access event journal.
+*
+*         Sector layout, in 20 byte slots:
+*           slot 0   header: magic, sequence number (one more than the other sector when it was formatted)
+*           slot 1.. events: time, decision, reason, UID size, UID padded with 0xFF, check byte; programmed as
+*                    five words, the word holding the check byte last
+*
+*         Events are appended in time order, so the index entry of every JOURNAL_INDEX_STRIDE-th slot bounds
+*         where a range query starts reading.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 14, 2023
+* @revision 1.0
+*
+*/
+
+#include <string.h>
+#include "journal.h"
+#include "crc8.h"
+#include "flash.h"
+#include "delay.h"
+
+#define JOURNAL_MAGIC		0x4A524E4CU		// "JRNL"
+#define JOURNAL_WORDS		(JOURNAL_RECORD_SIZE / 4)
+
+/* One flash record */
+typedef union {
+	struct {
+		uint32_t time;
+		uint8_t decision;
+		uint8_t reason;
+		uint8_t size;
+		uint8_t uid[MFRC522_UID_MAX_SIZE];
+		uint8_t reserved[2];
+		uint8_t check;
+	} r;
+	uint32_t words[JOURNAL_WORDS];
+} journal_record_t;
+
+/* Index entry, the time of the event in a slot */
+typedef struct {
+	uint32_t time;
+	uint16_t sector;	// Index in journal_sectors
+	uint16_t slot;
+} journal_index_t;
+
+static const uint8_t journal_sectors[2] = { JOURNAL_SECTOR_A, JOURNAL_SECTOR_B };
+static uint8_t journal_newest = 0;		// Index in journal_sectors of the sector being filled
+static bool journal_has_oldest;			// The other sector holds older events
+static bool journal_spare_erased;		// The other sector is erased, formatting it only writes the header
+static uint32_t journal_sequence;		// Sequence number of the newest sector
+static uint32_t journal_end[2];			// First free slot of each sector
+static uint32_t journal_records[2];		// Events in each sector
+
+static journal_index_t journal_index[JOURNAL_INDEX_SIZE];
+static uint8_t journal_index_head = 0;
+static uint8_t journal_index_count = 0;
+
+static journal_event_t journal_staging[JOURNAL_STAGING_SIZE];
+static uint8_t journal_staging_head = 0;			// Next event to write to flash
+static uint8_t journal_staging_tail = 0;			// Next free entry
+
+static uint32_t journal_seconds = 0;
+static uint32_t journal_ms = 0;
+static uint32_t journal_last_ms = 0;
+static journal_stats_t journal_stats;
+
+// Function to get the number of slots of a sector
+static uint32_t journal_slots(uint8_t sector) {
+	return flash_sector_size(journal_sectors[sector]) / JOURNAL_RECORD_SIZE;
+}
+
+// Function to get a record of a sector
+static const journal_record_t* journal_record(uint8_t sector, uint32_t slot) {
+	return (const journal_record_t*) (flash_sector_address(journal_sectors[sector]) + slot * JOURNAL_RECORD_SIZE);
+}
+
+// Function to compute the check byte of a record (CRC-8, polynomial 0x07), 0xFF is never used
+static uint8_t journal_check(const journal_record_t *record) {
+	uint8_t crc = crc8((const uint8_t*) record, JOURNAL_RECORD_SIZE - 1);
+
+	return (crc == 0xFF) ? 0x00 : crc;
+}
+
+// Function to check whether every word of a record is erased
+static bool journal_erased(const journal_record_t *record) {
+	uint8_t w;
+
+	for (w = 0; w < JOURNAL_WORDS; w++) {
+		if (record->words[w] != FLASH_ERASED_WORD) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Function to add the index entry of a slot holding an event, only every JOURNAL_INDEX_STRIDE-th slot has one
+static void journal_index_add(uint8_t sector, uint32_t slot, uint32_t time) {
+	journal_index_t *entry;
+
+	if (((slot - 1) % JOURNAL_INDEX_STRIDE) || (journal_index_count >= JOURNAL_INDEX_SIZE)) {
+		return;
+	}
+	entry = &journal_index[(journal_index_head + journal_index_count) % JOURNAL_INDEX_SIZE];
+	entry->time = time;
+	entry->sector = sector;
+	entry->slot = slot;
+	journal_index_count++;
+}
+
+// Function to drop the index entries of a sector, they are the oldest ones
+static void journal_index_drop(uint8_t sector) {
+	while (journal_index_count && (journal_index[journal_index_head].sector == sector)) {
+		journal_index_head = (journal_index_head + 1) % JOURNAL_INDEX_SIZE;
+		journal_index_count--;
+	}
+}
+
+// Function to get the n-th index entry, oldest first
+static const journal_index_t* journal_index_get(uint8_t n) {
+	return &journal_index[(journal_index_head + n) % JOURNAL_INDEX_SIZE];
+}
+
+// Function to check whether a sector holds a journal, and get its sequence number
+static bool journal_sector_valid(uint8_t sector, uint32_t *sequence) {
+	const uint32_t *header = (const uint32_t*) flash_sector_address(journal_sectors[sector]);
+
+	*sequence = header[1];
+	return (header[0] == JOURNAL_MAGIC) && (header[1] != FLASH_ERASED_WORD);
+}
+
+// Function to drop the events of a sector and erase it
+static bool journal_erase(uint8_t sector) {
+	journal_index_drop(sector);
+	journal_stats.events -= journal_records[sector];
+	journal_records[sector] = 0;
+	journal_stats.erases++;
+	return flash_erase_sector(journal_sectors[sector]) == 0;
+}
+
+// Function to erase a sector and make it the newest one, the erase is skipped if journal_prepare() did it
+static bool journal_format(uint8_t sector, uint32_t sequence) {
+	uintptr_t header = flash_sector_address(journal_sectors[sector]);
+	bool erased = journal_spare_erased && (sector != journal_newest);
+	uint32_t unused;
+
+	journal_spare_erased = false;
+	// A cut before the sequence number is written leaves an invalid sector, it is formatted again at mount
+	if ((!erased && !journal_erase(sector)) || (flash_program_word(header, JOURNAL_MAGIC) != 0)
+			|| (flash_program_word(header + 4, sequence) != 0)) {
+		// The newest sector stays full, so the next append formats this sector again
+		if (sector != journal_newest) {
+			journal_has_oldest = false;
+		}
+		return false;
+	}
+
+	journal_has_oldest = (sector != journal_newest) && journal_sector_valid(journal_newest, &unused);
+	journal_newest = sector;
+	journal_sequence = sequence;
+	journal_end[sector] = 1;
+	return true;
+}
+
+// Function to read the events of a sector at mount: find its end and index it
+static void journal_scan(uint8_t sector) {
+	const journal_record_t *record;
+	uint32_t slots = journal_slots(sector);
+	uint32_t slot;
+
+	journal_records[sector] = 0;
+	for (slot = 1; slot < slots; slot++) {
+		record = journal_record(sector, slot);
+		if (journal_erased(record)) {
+			break;
+		}
+		if (record->words[JOURNAL_WORDS - 1] == FLASH_ERASED_WORD) {
+			journal_stats.torn++;
+			continue;
+		}
+		journal_index_add(sector, slot, record->r.time);
+		journal_records[sector]++;
+		journal_stats.events++;
+		journal_seconds = record->r.time + 1;
+	}
+	journal_end[sector] = slot;
+}
+
+// Function to write one event to flash, the newest sector is replaced by the oldest one when it is full
+static bool journal_append(const journal_event_t *event) {
+	journal_record_t record;
+	uint8_t sector = journal_newest;
+	uint32_t slot;
+	uintptr_t address;
+	uint8_t w;
+	bool status = true;
+
+	if ((journal_end[sector] >= journal_slots(sector)) && !journal_format(sector ^ 1, journal_sequence + 1)) {
+		return false;
+	}
+	sector = journal_newest;
+	slot = journal_end[sector];
+	address = (uintptr_t) journal_record(sector, slot);
+
+	memset(&record, 0xFF, sizeof(record));
+	record.r.time = event->time;
+	record.r.decision = event->decision;
+	record.r.reason = event->reason;
+	record.r.size = event->size;
+	memcpy(record.r.uid, event->uid, event->size);
+	record.r.check = journal_check(&record);
+
+	// The slot is used even if the write fails, a half programmed slot is skipped when reading
+	for (w = 0; (w < JOURNAL_WORDS) && status; w++) {
+		status = (flash_program_word(address + 4 * w, record.words[w]) == 0);
+	}
+	journal_end[sector]++;
+	if (status) {
+		journal_index_add(sector, slot, event->time);
+		journal_records[sector]++;
+		journal_stats.events++;
+	}
+	return status;
+}
+
+// Function to mount the journal
+bool journal_init(void) {
+	uint32_t sequence[2];
+	bool valid[2];
+	uint8_t s;
+
+	memset(&journal_stats, 0, sizeof(journal_stats));
+	memset(journal_records, 0, sizeof(journal_records));
+	journal_index_head = 0;
+	journal_index_count = 0;
+	journal_staging_head = 0;
+	journal_staging_tail = 0;
+	journal_seconds = 0;
+	journal_ms = 0;
+	journal_last_ms = millis();
+	journal_spare_erased = false;
+
+	for (s = 0; s < 2; s++) {
+		valid[s] = journal_sector_valid(s, &sequence[s]);
+		journal_end[s] = 1;
+	}
+
+	if (!valid[0] && !valid[1]) {
+		// First boot, or both sectors damaged: start an empty journal
+		journal_newest = 1;
+		journal_end[1] = journal_slots(1);
+		journal_has_oldest = false;
+		return journal_format(0, 1);
+	}
+
+	journal_newest = (valid[1] && (!valid[0] || (int32_t) (sequence[1] - sequence[0]) > 0)) ? 1 : 0;
+	journal_sequence = sequence[journal_newest];
+	journal_has_oldest = valid[journal_newest ^ 1];
+	if (journal_has_oldest) {
+		journal_scan(journal_newest ^ 1);
+	}
+	journal_scan(journal_newest);
+	return true;
+}
+
+// Function to get the journal time
+uint32_t journal_time(void) {
+	uint32_t now = millis();
+
+	// Counting elapsed milliseconds keeps the time going when millis() wraps after 49 days
+	journal_ms += now - journal_last_ms;
+	journal_last_ms = now;
+	journal_seconds += journal_ms / 1000;
+	journal_ms %= 1000;
+	return journal_seconds;
+}
+
+// Function to record an event
+bool journal_log(journal_decision_t decision, journal_reason_t reason, const RC522_uid_t *uid) {
+	journal_event_t *event;
+	uint8_t tail = journal_staging_tail;
+
+	if ((uint8_t) (tail - journal_staging_head) >= JOURNAL_STAGING_SIZE) {
+		journal_stats.dropped++;
+		return false;
+	}
+
+	event = &journal_staging[tail % JOURNAL_STAGING_SIZE];
+	event->time = journal_time();
+	event->decision = decision;
+	event->reason = reason;
+	event->size = (uid->size <= MFRC522_UID_MAX_SIZE) ? uid->size : MFRC522_UID_MAX_SIZE;
+	memcpy(event->uid, uid->uid, event->size);
+	journal_staging_tail = tail + 1;
+	journal_stats.staged = (uint8_t) (journal_staging_tail - journal_staging_head);
+	return true;
+}
+
+// Function to write staged events to flash
+uint8_t journal_flush(uint8_t max) {
+	uint8_t written = 0;
+
+	while ((written < max) && (journal_staging_head != journal_staging_tail)) {
+		if (journal_append(&journal_staging[journal_staging_head % JOURNAL_STAGING_SIZE])) {
+			written++;
+		} else {
+			journal_stats.failed++;
+		}
+		journal_staging_head++;
+	}
+	journal_stats.staged = (uint8_t) (journal_staging_tail - journal_staging_head);
+	return written;
+}
+
+// Function to erase the oldest sector before the newest one is full
+bool journal_prepare(void) {
+	uint8_t sector = journal_newest ^ 1;
+
+	if (journal_spare_erased || (journal_end[journal_newest] + JOURNAL_SPARE_SLOTS < journal_slots(journal_newest))) {
+		return false;
+	}
+	journal_has_oldest = false;
+	journal_spare_erased = journal_erase(sector);
+	return true;
+}
+
+// Function to call a function with every event recorded in a time range
+uint32_t journal_query(uint32_t from, uint32_t to, void (*callback)(const journal_event_t *event)) {
+	const journal_record_t *record;
+	journal_event_t event;
+	uint8_t sector = journal_has_oldest ? journal_newest ^ 1 : journal_newest;
+	uint32_t slot = 1;
+	uint32_t found = 0;
+	uint8_t low = 0;
+	uint8_t high = journal_index_count;
+	uint8_t mid;
+
+	// Start at the last indexed event before the range, the events before it are all older
+	while (low < high) {
+		mid = (low + high) / 2;
+		if (journal_index_get(mid)->time < from) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	if (low > 0) {
+		sector = journal_index_get(low - 1)->sector;
+		slot = journal_index_get(low - 1)->slot;
+	}
+
+	journal_stats.scanned = 0;
+	while (1) {
+		if (slot >= journal_end[sector]) {
+			if (sector == journal_newest) {
+				break;
+			}
+			sector = journal_newest;
+			slot = 1;
+			continue;
+		}
+
+		record = journal_record(sector, slot++);
+		journal_stats.scanned++;
+		if ((record->words[JOURNAL_WORDS - 1] == FLASH_ERASED_WORD) || (record->r.check != journal_check(record))) {
+			continue;
+		}
+		if (record->r.time > to) {
+			break;
+		}
+		if (record->r.time >= from) {
+			event.time = record->r.time;
+			event.decision = record->r.decision;
+			event.reason = record->r.reason;
+			event.size = record->r.size;
+			memcpy(event.uid, record->r.uid, MFRC522_UID_MAX_SIZE);
+			callback(&event);
+			found++;
+		}
+	}
+	return found;
+}
+
+// Function to get the state of the journal
+const journal_stats_t* journal_get_stats(void) {
+	return &journal_stats;
+}
@@ -28,7 +28,8 @@
 #include "keypad.h"
 #include "delay.h"
 
-volatile uint8_t buttonState[3][3] = { 0 };
+volatile uint8_t buttonState[KEYPAD_ROWS][KEYPAD_COLS] = { 0 };
+static uint32_t changed_ms[KEYPAD_ROWS][KEYPAD_COLS] = { 0 };
 uint32_t volatile *RCC_Base_Addr = (uint32_t*) 0x40023830;
 uint32_t volatile *GPIOModer = (uint32_t*) 0x40020800;
 
@@ -59,163 +60,52 @@ void init_keypad(void) {
 
 }
 
-char* check_key(void) {
-//*****************************************ROW 1*********************************************************
+// Function to scan the four rows once and report the key that went down
+char keypad_scan(void) {
+	static const char keys[KEYPAD_ROWS][KEYPAD_COLS] = { { '1', '2', '3' }, { '4', '5', '6' }, { '7', '8', '9' },
+			{ '*', '0', '#' } };
+	uint32_t now = millis();
 	char ch = '\0';
-	bool button_pressed = false;
-	int i = 0;
-	memset(key_data, 0, 50);
-
-	while (1) {
-		*GPIOOutput |= (0xFF << 0);	// Set the value
-
-		*GPIOOutput &= ~(1 << 0);	// 0th row
-
-		if (!(*GPIOIntput & (1 << 4)) && !buttonState[0][0]) {	// Check GPIO state
-			button_pressed = true;
-			ch = '1';
-			buttonState[0][0] = 1;
-			delay(50); // Debounce delay
-
-		} else if (*GPIOIntput & (1 << 4)) {
-			buttonState[0][0] = 0;
-		}
-
-		if (!(*GPIOIntput & (1 << 5)) && !buttonState[0][1]) {	// Check GPIO state
-			button_pressed = true;
-			ch = '2';
-			buttonState[0][1] = 1;
-			delay(50); // Debounce delay
-		} else if (*GPIOIntput & (1 << 5)) {
-			buttonState[0][1] = 0;
-		}
-
-		if (!(*GPIOIntput & (1 << 6)) && !buttonState[0][2]) {	// Check GPIO state
-			button_pressed = true;
-			ch = '3';
-			buttonState[0][2] = 1;
-			delay(50); // Debounce delay
-		} else if (*GPIOIntput & (1 << 6)) {
-			buttonState[0][2] = 0;
-		}
-
-//*****************************************ROW 2*********************************************************
-
-		*GPIOOutput |= (0x0F << 0);
-
-		*GPIOOutput &= ~(1 << 1);	// 1st row
-
-		if (!(*GPIOIntput & (1 << 4)) && !buttonState[1][0]) {	// Check GPIO state
-			button_pressed = true;
-			ch = '4';
-			buttonState[1][0] = 1;
-			delay(50); // Debounce delay
-
-		} else if (*GPIOIntput & (1 << 4)) {
-			buttonState[1][0] = 0;
-		}
-
-		if (!(*GPIOIntput & (1 << 5)) && !buttonState[1][1]) {	// Check GPIO state
-			button_pressed = true;
-			ch = '5';
-			buttonState[1][1] = 1;
-			delay(50); // Debounce delay
-		} else if (*GPIOIntput & (1 << 5)) {
-			buttonState[1][1] = 0;
-		}
-
-		if (!(*GPIOIntput & (1 << 6)) && !buttonState[1][2]) {	// Check GPIO state
-			button_pressed = true;
-			ch = '6';
-			buttonState[1][2] = 1;
-			delay(50); // Debounce delay
-		} else if (*GPIOIntput & (1 << 6)) {
-			buttonState[1][2] = 0;
-		}
+	uint8_t pressed;
+	int row;
+	int col;
 
-//*****************************************ROW 3*********************************************************
+	for (row = 0; row < KEYPAD_ROWS; row++) {
 		*GPIOOutput |= (0x0F << 0);
-
-		*GPIOOutput &= ~(1 << 2);	// 2nd row
-
-		if (!(*GPIOIntput & (1 << 4)) && !buttonState[2][0]) {	// Check GPIO state
-			button_pressed = true;
-			ch = '7';
-			buttonState[2][0] = 1;
-			delay(50); // Debounce delay
-
-		} else if (*GPIOIntput & (1 << 4)) {
-			buttonState[2][0] = 0;
-		}
-
-		if (!(*GPIOIntput & (1 << 5)) && !buttonState[2][1]) {	// Check GPIO state
-			button_pressed = true;
-			ch = '8';
-			buttonState[2][1] = 1;
-			delay(50); // Debounce delay
-		} else if (*GPIOIntput & (1 << 5)) {
-			buttonState[2][1] = 0;
-		}
-
-		if (!(*GPIOIntput & (1 << 6)) && !buttonState[2][2]) {	// Check GPIO state
-			button_pressed = true;
-			ch = '9';
-			buttonState[2][2] = 1;
-			delay(50); // Debounce delay
-		} else if (*GPIOIntput & (1 << 6)) {
-			buttonState[2][2] = 0;
-		}
-
-//*****************************************ROW 4*********************************************************
-
-		*GPIOOutput |= (0x0F << 0);
-
-		*GPIOOutput &= ~(1 << 3);	// 4th row
-
-		if (!(*GPIOIntput & (1 << 4)) && !buttonState[3][0]) {	// Check GPIO state
-			//USART2_StringTransmit("* \r\n");
-			button_pressed = true;
-			ch = '*';
-			buttonState[3][0] = 1;
-			delay(50); // Debounce delay
-
-		} else if (*GPIOIntput & (1 << 4)) {
-			buttonState[3][0] = 0;
+		*GPIOOutput &= ~(1 << row);	// Drive one row low, a pressed key pulls its column low
+
+		for (col = 0; col < KEYPAD_COLS; col++) {
+			pressed = !(*GPIOIntput & (1 << (col + 4)));
+			// Contact bounce is ignored by holding each key state for the debounce time
+			if ((pressed == buttonState[row][col]) || (now - changed_ms[row][col] < KEYPAD_DEBOUNCE_MS)) {
+				continue;
+			}
+			buttonState[row][col] = pressed;
+			changed_ms[row][col] = now;
+			if (pressed && (ch == '\0')) {
+				ch = keys[row][col];
+			}
 		}
+	}
+	return ch;
+}
 
-		if (!(*GPIOIntput & (1 << 5)) && !buttonState[3][1]) {	// Check GPIO state
-			//USART2_StringTransmit("0 \r\n");
-			button_pressed = true;
-			ch = '0';
-			buttonState[3][1] = 1;
-			delay(50); // Debounce delay
-		} else if (*GPIOIntput & (1 << 5)) {
-			buttonState[3][1] = 0;
-		}
+// Function to read digits until '#' is pressed
+char* check_key(void) {
+	char ch;
+	int i = 0;
+	memset(key_data, 0, 50);
 
-		if (!(*GPIOIntput & (1 << 6)) && !buttonState[3][2]) {	// Check GPIO state
-			//USART2_StringTransmit("# \r\n");
-			button_pressed = true;
-			ch = '#';
-			buttonState[3][2] = 1;
-			delay(50); // Debounce delay
-		} else if (*GPIOIntput & (1 << 6)) {
-			buttonState[3][2] = 0;
-		}
-		if (ch == '#')
-			break;												// Break if delimiter detected
-		if ((button_pressed == true) && (!((!(ch == '*')) || (ch == '#')))) {
+	while ((ch = keypad_scan()) != '#') {						// Break if delimiter detected
+		if (ch == '*') {
 #ifdef DEBUG
 			USART2_string_transmit(
 					"Invalid input. Please enter digits only.\r\n");
 #endif
-		} else if ((button_pressed == true) && ((ch >= '0') && (ch <= '9'))) {
+		} else if ((ch >= '0') && (ch <= '9') && (i < (int) sizeof(key_data) - 1)) {
 			key_data[i] = ch;
 			i++;
-			ch = '\0';
 		}
 	}
 	return key_data;
-
 }
-
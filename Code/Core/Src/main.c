@@ -29,18 +29,95 @@
 #include "oled.h"
 #include "keypad.h"
 #include "security_system_interface.h"
+#include "rfid_trace.h"
+#include "debug_log.h"
+#include "journal.h"
+#include "credential_store.h"
+#include "scheduler.h"
+#include "pin.h"
 
 #define SIXTEEN_MHZ	16000000
 
+// Function to write one staged access event to flash when no other task is due, or to erase the oldest journal
+// sector once nothing is staged, no door decision is in progress and no card is on the reader
+static void journal_task(void) {
+	if (!journal_flush(1) && (access_get_state() == ACCESS_IDLE) && !RC522_field_busy()) {
+		journal_prepare();
+	}
+}
+
+// Function to move the enrolled cards to the other store sector ahead of time, under the same conditions as
+// the journal erase, so the admin never waits for a 128 KB erase while enrolling a card
+static void store_task(void) {
+	if ((access_get_state() == ACCESS_IDLE) && !RC522_field_busy()) {
+		credential_store_prepare();
+	}
+}
+
+#ifdef DEBUG
+// Function to queue one deferred driver message for the USART2 interrupt when the loop is idle, only if the
+// transmit buffer has room for it so the task never waits for the UART
+static void log_task(void) {
+	if (USART2_tx_free() >= 2 * DEBUG_LOG_LINE_SIZE) {
+		debug_log_flush(USART2_string_transmit, 1);
+	}
+}
+
+// Function to answer the USART2 commands
+static void uart_task(void) {
+	if (!USART2_data_available()) {
+		return;
+	}
+	switch (USART2_receive()) {
+	case 's':
+		// Run time of every task, to find the source of loop jitter
+		scheduler_dump(USART2_string_transmit);
+		scheduler_clear_stats();
+		break;
+#ifdef MFRC522_TRACE_ENABLE
+	case 't':
+		// RC522 register trace for Simulator/trace_decode
+		rfid_trace_dump(USART2_string_transmit);
+		rfid_trace_clear();
+		break;
+#endif
+	default:
+		break;
+	}
+}
+#endif
+
+#ifdef DEBUG
+// Function to print the time of one PIN check at the HSI clock and scaled to the 100 MHz PLL clock, before the
+// flash wait states the PLL clock needs
+static void pin_timing(void) {
+	static const pin_hash_t test = { { 0 }, { 0 } };
+	char line[96];
+	uint32_t start = cycles();
+	uint32_t count;
+
+	pin_verify(&test, "0000");
+	count = cycles() - start;
+	sprintf(line, "PIN check %lu cycles, %lu us at 16 MHz, %lu us at 100 MHz\r\n", (unsigned long) count,
+			(unsigned long) cycles_to_us(count), (unsigned long) (count / 100));
+	USART2_string_transmit(line);
+}
+#endif
+
 int main(void) {
 	systick_init_ms(SIXTEEN_MHZ);	// Initialize system clock
 	beeper_init();					// Initialize buzzer (beeper)
 	RC522_init();					// Initialize RFID reader module
+#ifdef MFRC522_IRQ_ENABLE
+	RC522_irq_init();				// Detect cards through the RC522 IRQ line
+#endif
 	SSD1106_init();					// Initialize OLED display
 	SSD1106_gotoXY(0, 0);			// Set the cursor to (0,0) location on the OLED
 	init_keypad();					// Initialize keypad
+	security_system_init();			// Load the allowed cards
 #ifdef DEBUG
 	USART2_init();
+	pin_timing();
 	USART2_string_transmit("Please tap card \r\n");
 #endif
 	SSD1106_clear_screen();			// Clear the OLED screen
@@ -51,7 +128,20 @@ int main(void) {
 	SSD1106_clear_line();			// Clear the line
 	SSD1106_update_screen(); 		// Display the content set above on OLED
 
-	while (1) {
-		check_access();				// Check the card access on every tap
-	}
+	// Tasks of the main loop: name, function, period in ms, priority (0 is the most urgent)
+	scheduler_add("beeper", beeper_update, 5, 0);					// End the beep once it is long enough
+	scheduler_add("voice", voice_update, 5, 0);					// End the voice module trigger pulse
+	scheduler_add("keypad", access_poll_keypad, 10, 1);			// Keys of a password
+	scheduler_add("timers", access_update_timers, 10, 2);			// Password timeout, end of a decision
+	scheduler_add("rfid", access_poll_cards, 20, 3);				// Card taps
+	scheduler_add("oled", SSD1106_flush, 50, 4);					// Send the changed screen over I2C
+#ifdef DEBUG
+	scheduler_add("uart", uart_task, 10, 5);						// Commands
+#endif
+	scheduler_add("journal", journal_task, SCHEDULER_BACKGROUND, 0);	// Staged access events to flash
+	scheduler_add("store", store_task, SCHEDULER_BACKGROUND, 0);		// Enrolled cards compaction
+#ifdef DEBUG
+	scheduler_add("log", log_task, SCHEDULER_BACKGROUND, 0);		// Deferred driver messages
+#endif
+	scheduler_run();
 }
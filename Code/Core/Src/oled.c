@@ -37,6 +37,7 @@ typedef struct {
 
 /* Private variable */
 static SSD1106_t SSD1106;
+static uint8_t SSD1106_dirty = 0;	// Buffer changed since the last update
 
 #define SSD1106_DEACTIVATE_SCROLL                    0x2E // Stop scroll
 
@@ -99,6 +100,7 @@ uint8_t SSD1106_init(void) {
 void SSD1106_update_screen(void) {
 	uint8_t m;
 
+	SSD1106_dirty = 0;
 	for (m = 0; m < 8; m++) {
 		SSD1106_WRITECOMMAND(0xB0 + m);
 		SSD1106_WRITECOMMAND(0x00);
@@ -110,10 +112,17 @@ void SSD1106_update_screen(void) {
 	}
 }
 
+void SSD1106_flush(void) {
+	if (SSD1106_dirty) {
+		SSD1106_update_screen();
+	}
+}
+
 void SSD1106_fill(SSD1106_COLOR_t color) {
 	/* Set memory */
 	memset(SSD1106_Buffer, (color == SSD1106_COLOR_BLACK) ? 0x00 : 0xFF,
 			sizeof(SSD1106_Buffer));
+	SSD1106_dirty = 1;
 }
 
 void SSD1106_draw_pixel(uint16_t x, uint16_t y, SSD1106_COLOR_t color) {
@@ -121,6 +130,8 @@ void SSD1106_draw_pixel(uint16_t x, uint16_t y, SSD1106_COLOR_t color) {
 		return;
 	}
 
+	SSD1106_dirty = 1;
+
 	/* Set color */
 	if (color == SSD1106_COLOR_WHITE) {
 		SSD1106_Buffer[x + (y / 8) * SSD1106_WIDTH] |= 1 << (y % 8);
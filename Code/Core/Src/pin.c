@@ -0,0 +1,56 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   pin.c
+* @brief  A file defining the salted PIN hashes.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 17, 2023
+* @revision 1.0
+*
+*/
+
+#include <string.h>
+#include "pin.h"
+
+// Function to hash a PIN with a salt
+void pin_hash(const char *pin, const uint8_t *salt, pin_hash_t *out) {
+	sha256_t ctx;
+
+	memcpy(out->salt, salt, PIN_SALT_SIZE);
+	sha256_init(&ctx);
+	sha256_update(&ctx, salt, PIN_SALT_SIZE);
+	sha256_update(&ctx, pin, strlen(pin));
+	sha256_final(&ctx, out->hash);
+	memset(&ctx, 0, sizeof(ctx));
+}
+
+// Function to compare two arrays, every byte is read whatever the earlier ones were
+bool pin_equal(const uint8_t *a, const uint8_t *b, uint8_t length) {
+	volatile uint8_t diff = 0;
+	uint8_t i;
+
+	for (i = 0; i < length; i++) {
+		diff |= a[i] ^ b[i];
+	}
+	return diff == 0;
+}
+
+// Function to check an entered PIN
+bool pin_verify(const pin_hash_t *stored, const char *pin) {
+	pin_hash_t entered;
+	bool match;
+
+	pin_hash(pin, stored->salt, &entered);
+	match = pin_equal(entered.hash, stored->hash, SHA256_DIGEST_SIZE) & (strlen(pin) <= PIN_MAX_LENGTH);
+	memset(&entered, 0, sizeof(entered));
+	return match;
+}
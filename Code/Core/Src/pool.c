@@ -0,0 +1,82 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   pool.c
+* @brief  A file defining the fixed size block pool.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 15, 2023
+* @revision 1.0
+*
+*/
+
+#include <string.h>
+#include "pool.h"
+
+// Function to get the address of a block
+void* pool_block(const pool_t *pool, uint16_t block) {
+	return pool->memory + (uint32_t) block * pool->block_size;
+}
+
+// Function to set up an empty pool
+void pool_init(pool_t *pool, void *memory, uint16_t block_size, uint16_t blocks, uint32_t *used) {
+	pool->memory = memory;
+	pool->block_size = block_size;
+	pool->used = used;
+	pool->stats.blocks = blocks;
+	pool_reset(pool);
+}
+
+// Function to free every block
+void pool_reset(pool_t *pool) {
+	pool->free = POOL_NONE;
+	pool->fresh = 0;
+	pool->stats.used = 0;
+	pool->stats.peak = 0;
+	pool->stats.failures = 0;
+	memset(pool->used, 0, POOL_USED_WORDS(pool->stats.blocks) * sizeof(uint32_t));
+}
+
+// Function to allocate a block, a freed one first so the blocks in use stay packed at the start
+uint16_t pool_alloc(pool_t *pool) {
+	uint16_t block;
+
+	if (pool->free != POOL_NONE) {
+		block = pool->free;
+		// Blocks have no alignment, the link is copied byte by byte
+		memcpy(&pool->free, pool_block(pool, block), sizeof(pool->free));
+	} else if (pool->fresh < pool->stats.blocks) {
+		block = pool->fresh++;
+	} else {
+		pool->stats.failures++;
+		return POOL_NONE;
+	}
+
+	pool->used[block / 32] |= 1UL << (block % 32);
+	pool->stats.used++;
+	if (pool->stats.used > pool->stats.peak) {
+		pool->stats.peak = pool->stats.used;
+	}
+	return block;
+}
+
+// Function to give a block back
+void pool_free(pool_t *pool, uint16_t block) {
+	// A second free would link the block into the free list twice and hand it out to two owners
+	if ((block >= pool->fresh) || !(pool->used[block / 32] & (1UL << (block % 32)))) {
+		pool->stats.failures++;
+		return;
+	}
+	pool->used[block / 32] &= ~(1UL << (block % 32));
+	memcpy(pool_block(pool, block), &pool->free, sizeof(pool->free));
+	pool->free = block;
+	pool->stats.used--;
+}
@@ -19,18 +19,102 @@
 */
 
 #include "stdio.h"
+#include "string.h"
 #include "RFID.h"
 #include "SPI.h"
 #include "stdbool.h"
 #include "stm32f4xx.h"
 #include "delay.h"
+#include "rfid_trace.h"
+#include "debug_log.h"
 
 /*
  * STM32 ->RFID
  * SPI  -> SPI
  * PA8  ->RST
  * PB0  ->CS
+ * PB1  ->IRQ (optional, see MFRC522_IRQ_ENABLE)
+ * MFRC522_LPCD_ENABLE keeps the RC522 in soft power-down between detection slots
  * */
+
+static volatile bool RC522_irq_flag = false;
+static bool RC522_irq_mode = false;
+static bool RC522_irq_request_active = false;
+static uint32_t RC522_irq_request_start;
+static uint8_t RC522_burst_tx[MFRC522_FIFO_SIZE + 1];	// FIFO burst buffers, the DMA reads them after the call
+static uint8_t RC522_burst_rx[MFRC522_FIFO_SIZE + 1];
+static volatile int8_t RC522_burst_status;
+static uint8_t RC522_last_error = 0;
+static uint32_t RC522_lpcd_next_slot = 0;
+static RC522_lpcd_stats_t RC522_lpcd_stats = { .interval_ms = MFRC522_LPCD_INTERVAL_MS };
+
+/* Recently-seen UIDs with the time they were last read */
+typedef struct {
+	bool used;
+	uint32_t last_seen;
+	RC522_uid_t uid;
+} RC522_seen_entry_t;
+
+static RC522_seen_entry_t RC522_seen[MFRC522_SEEN_CACHE_SIZE];
+static uint32_t RC522_hold_off_ms = MFRC522_HOLD_OFF_MS;
+
+/*
+ * Write-through shadow of the configuration registers the RC522 never changes on its own.
+ * Reads of these are served from RAM and writes of an unchanged value are skipped.
+ * Status registers (COMM_IRQ, DIV_IRQ, ERROR, FIFO_*, CONTROL, COMMAND, ...) always go to the device.
+ */
+#define RC522_REG_BIT(reg)	(1ULL << (reg))
+static const uint64_t RC522_shadow_cacheable = RC522_REG_BIT(MFRC522_REG_COMM_IE_N)
+		| RC522_REG_BIT(MFRC522_REG_DIV_IE_N) | RC522_REG_BIT(MFRC522_REG_BIT_FRAMING)
+		| RC522_REG_BIT(MFRC522_REG_MODE) | RC522_REG_BIT(MFRC522_REG_TX_CONTROL)
+		| RC522_REG_BIT(MFRC522_REG_TX_AUTO) | RC522_REG_BIT(MFRC522_REG_T_MODE)
+		| RC522_REG_BIT(MFRC522_REG_T_PRESCALER) | RC522_REG_BIT(MFRC522_REG_T_RELOAD_H)
+		| RC522_REG_BIT(MFRC522_REG_T_RELOAD_L);
+static uint64_t RC522_shadow_valid = 0;
+static uint8_t RC522_shadow[64];
+
+// CRC_A lookup table, polynomial x^16 + x^12 + x^5 + 1 processed LSB first (0x8408)
+static const uint16_t RC522_crc_a_table[256] = {
+	0x0000, 0x1189, 0x2312, 0x329B, 0x4624, 0x57AD, 0x6536, 0x74BF,
+	0x8C48, 0x9DC1, 0xAF5A, 0xBED3, 0xCA6C, 0xDBE5, 0xE97E, 0xF8F7,
+	0x1081, 0x0108, 0x3393, 0x221A, 0x56A5, 0x472C, 0x75B7, 0x643E,
+	0x9CC9, 0x8D40, 0xBFDB, 0xAE52, 0xDAED, 0xCB64, 0xF9FF, 0xE876,
+	0x2102, 0x308B, 0x0210, 0x1399, 0x6726, 0x76AF, 0x4434, 0x55BD,
+	0xAD4A, 0xBCC3, 0x8E58, 0x9FD1, 0xEB6E, 0xFAE7, 0xC87C, 0xD9F5,
+	0x3183, 0x200A, 0x1291, 0x0318, 0x77A7, 0x662E, 0x54B5, 0x453C,
+	0xBDCB, 0xAC42, 0x9ED9, 0x8F50, 0xFBEF, 0xEA66, 0xD8FD, 0xC974,
+	0x4204, 0x538D, 0x6116, 0x709F, 0x0420, 0x15A9, 0x2732, 0x36BB,
+	0xCE4C, 0xDFC5, 0xED5E, 0xFCD7, 0x8868, 0x99E1, 0xAB7A, 0xBAF3,
+	0x5285, 0x430C, 0x7197, 0x601E, 0x14A1, 0x0528, 0x37B3, 0x263A,
+	0xDECD, 0xCF44, 0xFDDF, 0xEC56, 0x98E9, 0x8960, 0xBBFB, 0xAA72,
+	0x6306, 0x728F, 0x4014, 0x519D, 0x2522, 0x34AB, 0x0630, 0x17B9,
+	0xEF4E, 0xFEC7, 0xCC5C, 0xDDD5, 0xA96A, 0xB8E3, 0x8A78, 0x9BF1,
+	0x7387, 0x620E, 0x5095, 0x411C, 0x35A3, 0x242A, 0x16B1, 0x0738,
+	0xFFCF, 0xEE46, 0xDCDD, 0xCD54, 0xB9EB, 0xA862, 0x9AF9, 0x8B70,
+	0x8408, 0x9581, 0xA71A, 0xB693, 0xC22C, 0xD3A5, 0xE13E, 0xF0B7,
+	0x0840, 0x19C9, 0x2B52, 0x3ADB, 0x4E64, 0x5FED, 0x6D76, 0x7CFF,
+	0x9489, 0x8500, 0xB79B, 0xA612, 0xD2AD, 0xC324, 0xF1BF, 0xE036,
+	0x18C1, 0x0948, 0x3BD3, 0x2A5A, 0x5EE5, 0x4F6C, 0x7DF7, 0x6C7E,
+	0xA50A, 0xB483, 0x8618, 0x9791, 0xE32E, 0xF2A7, 0xC03C, 0xD1B5,
+	0x2942, 0x38CB, 0x0A50, 0x1BD9, 0x6F66, 0x7EEF, 0x4C74, 0x5DFD,
+	0xB58B, 0xA402, 0x9699, 0x8710, 0xF3AF, 0xE226, 0xD0BD, 0xC134,
+	0x39C3, 0x284A, 0x1AD1, 0x0B58, 0x7FE7, 0x6E6E, 0x5CF5, 0x4D7C,
+	0xC60C, 0xD785, 0xE51E, 0xF497, 0x8028, 0x91A1, 0xA33A, 0xB2B3,
+	0x4A44, 0x5BCD, 0x6956, 0x78DF, 0x0C60, 0x1DE9, 0x2F72, 0x3EFB,
+	0xD68D, 0xC704, 0xF59F, 0xE416, 0x90A9, 0x8120, 0xB3BB, 0xA232,
+	0x5AC5, 0x4B4C, 0x79D7, 0x685E, 0x1CE1, 0x0D68, 0x3FF3, 0x2E7A,
+	0xE70E, 0xF687, 0xC41C, 0xD595, 0xA12A, 0xB0A3, 0x8238, 0x93B1,
+	0x6B46, 0x7ACF, 0x4854, 0x59DD, 0x2D62, 0x3CEB, 0x0E70, 0x1FF9,
+	0xF78F, 0xE606, 0xD49D, 0xC514, 0xB1AB, 0xA022, 0x92B9, 0x8330,
+	0x7BC7, 0x6A4E, 0x58D5, 0x495C, 0x3DE3, 0x2C6A, 0x1EF1, 0x0F78
+};
+
+// Commands are 4 bits wide, so the timing table is indexed by the command code
+static RC522_command_timing_t RC522_timing[16] = {
+	[PCD_TRANSCEIVE] = { .timeout_us = MFRC522_TRANSCEIVE_TIMEOUT_US },
+	[PCD_AUTHENT] = { .timeout_us = MFRC522_AUTHENT_TIMEOUT_US },
+	[PCD_CALCCRC] = { .timeout_us = MFRC522_CALCCRC_TIMEOUT_US },
+};
  
 // Function to initialize the RC522 RFID reader
 void RC522_init(void) {
@@ -48,18 +132,129 @@ void RC522_init(void) {
 	GPIOA->BSRR = GPIO_BSRR_BS8;
 	delay(50);
 	RC522_reset();
+	RC522_probe_spi_clock();
 
 	RC522_reg_write8(MFRC522_REG_T_MODE, 0x80); // Timer starts automatically at the end of the transmission
 	RC522_reg_write8(MFRC522_REG_T_PRESCALER, 0xA9); // The lower TPrescaler value
-	RC522_reg_write8(MFRC522_REG_T_RELOAD_L, 0xE8); // Lower 8 bits of the 16-bit timer reload value
-	RC522_reg_write8(MFRC522_REG_T_RELOAD_H, 0x03); // Higher 8 bits of the 16-bit timer reload value
+	RC522_reg_write8(MFRC522_REG_T_RELOAD_L, MFRC522_TIMER_RELOAD & 0xFF); // Lower 8 bits of the 16-bit timer reload value
+	RC522_reg_write8(MFRC522_REG_T_RELOAD_H, MFRC522_TIMER_RELOAD >> 8); // Higher 8 bits of the 16-bit timer reload value
 
 	RC522_reg_write8(MFRC522_REG_TX_AUTO, 0x40);
 	RC522_reg_write8(MFRC522_REG_MODE, 0x3D);
 
+#ifdef DEBUG
+	if (!RC522_crc_self_test()) {
+		debug_log(DEBUG_LOG_RC522_CRC_SELF_TEST, 0, 0);
+	}
+#endif
+
 	RC522_antenna_ON();   // Open the antenna to read any RFID tags 
 }
 
+// Function to check the version register against the chip versions known to work with this driver
+static bool RC522_version_valid(uint8_t version) {
+	switch (version) {
+	case 0x88:	// FM17522 clone
+	case 0x90:	// MFRC522 v0.0
+	case 0x91:	// MFRC522 v1.0
+	case 0x92:	// MFRC522 v2.0
+	case 0xB2:	// FM17522 clone
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Function to step the SPI clock up until version register reads fail
+uint32_t RC522_probe_spi_clock(void) {
+	uint16_t initial = spi_get_clock_divider();
+	uint16_t good = 0;
+	uint16_t divider;
+	uint8_t version = 0;
+	uint8_t i;
+
+	for (divider = 256; divider >= 2; divider >>= 1) {
+		spi_set_clock_divider(divider);
+		if (spi_get_clock_hz() > MFRC522_MAX_SPI_HZ) {
+			break;
+		}
+
+		// Every read at this clock must return the same, known version
+		for (i = 0; i < MFRC522_PROBE_READS; i++) {
+			uint8_t v = RC522_reg_read8(MFRC522_REG_VERSION);
+			if (!RC522_version_valid(v) || ((i != 0) && (v != version))) {
+				break;
+			}
+			version = v;
+		}
+		if (i != MFRC522_PROBE_READS) {
+			break;
+		}
+		good = divider;
+	}
+
+	if (good == 0) {
+		spi_set_clock_divider(initial);
+		return 0;
+	}
+
+	spi_set_clock_divider(good);
+	return spi_get_clock_hz();
+}
+
+// Function to route the RC522 IRQ output to EXTI1 and switch card detection to interrupt mode
+void RC522_irq_init(void) {
+	RCC->AHB1ENR |= RCC_AHB1ENR_GPIOBEN;
+	RCC->APB2ENR |= RCC_APB2ENR_SYSCFGEN;
+
+	// PB1 as input with pull-up
+	GPIOB->MODER &= ~GPIO_MODER_MODE1;
+	GPIOB->PUPDR = (GPIOB->PUPDR & ~GPIO_PUPDR_PUPD1) | GPIO_PUPDR_PUPD1_0;
+
+	// EXTI1 on PB1, falling edge
+	SYSCFG->EXTICR[0] = (SYSCFG->EXTICR[0] & ~SYSCFG_EXTICR1_EXTI1) | SYSCFG_EXTICR1_EXTI1_PB;
+	EXTI->RTSR &= ~EXTI_RTSR_TR1;
+	EXTI->FTSR |= EXTI_FTSR_TR1;
+	EXTI->PR = EXTI_PR_PR1;
+	EXTI->IMR |= EXTI_IMR_MR1;
+
+	RC522_reg_write8(MFRC522_REG_DIV_IE_N, 0x80); // IRQPushPull = 1, IRQ pin is a standard CMOS output
+
+	NVIC_EnableIRQ(EXTI1_IRQn);
+	RC522_irq_mode = true;
+}
+
+// RC522 IRQ line interrupt
+void EXTI1_IRQHandler(void) {
+	if (EXTI->PR & EXTI_PR_PR1) {
+		EXTI->PR = EXTI_PR_PR1;
+		RC522_irq_flag = true;
+	}
+}
+
+// Function to set the completion deadline of a command
+void RC522_set_command_timeout(uint8_t command, uint32_t timeout_us) {
+	RC522_timing[command & 0x0F].timeout_us = timeout_us;
+}
+
+// Function to get the completion deadline and poll statistics of a command
+const RC522_command_timing_t* RC522_get_command_timing(uint8_t command) {
+	return &RC522_timing[command & 0x0F];
+}
+
+// Function to record how many status polls a command needed
+static void RC522_record_polls(uint8_t command, uint16_t polls, bool done) {
+	RC522_command_timing_t *timing = &RC522_timing[command & 0x0F];
+
+	timing->last_polls = polls;
+	if (polls > timing->max_polls) {
+		timing->max_polls = polls;
+	}
+	if (!done) {
+		timing->timeouts++;
+	}
+}
+
 // Function to control the state of the RFID CS pin
 void RC522_spi_cs_write(bool state) {
 	if (state) {
@@ -71,21 +266,116 @@ void RC522_spi_cs_write(bool state) {
 
 // Function to read a register (8 bits) from the RC522
 uint8_t RC522_reg_read8(uint8_t reg) {
+	if (RC522_shadow_valid & RC522_REG_BIT(reg)) {
+		RFID_TRACE(RFID_TRACE_READ_SHADOW, reg, RC522_shadow[reg]);
+		return RC522_shadow[reg];
+	}
+
+	uint8_t txData[2] = { ((reg << 1) & 0x7E) | 0x80, 0x00 };
+	uint8_t rxData[2] = { 0 };
+
+	// The register value is clocked in while the trailing dummy byte is sent
 	RC522_spi_cs_write(0);
-	reg = ((reg << 1) & 0x7E) | 0x80;
-	spi_transmit(&reg, 1);
-	uint8_t dataRd = 0;
-	spi_receive(&dataRd, 1);
+	spi_transfer(txData, rxData, 2);
 	RC522_spi_cs_write(1);
-	return dataRd;
+
+	if (RC522_shadow_cacheable & RC522_REG_BIT(reg)) {
+		RC522_shadow[reg] = rxData[1];
+		RC522_shadow_valid |= RC522_REG_BIT(reg);
+	}
+	RFID_TRACE(RFID_TRACE_READ, reg, rxData[1]);
+	return rxData[1];
 }
 
 // Function to write a value (8 bits) to a register in the RC522
 void RC522_reg_write8(uint8_t reg, uint8_t data8) {
+	if (RC522_shadow_cacheable & RC522_REG_BIT(reg)) {
+		if ((RC522_shadow_valid & RC522_REG_BIT(reg)) && (RC522_shadow[reg] == data8)) {
+			RFID_TRACE(RFID_TRACE_WRITE_SKIP, reg, data8);
+			return;
+		}
+		RC522_shadow[reg] = data8;
+		RC522_shadow_valid |= RC522_REG_BIT(reg);
+	}
+
 	RC522_spi_cs_write(0);
 	uint8_t txData[2] = { 0x7E & (reg << 1), data8 };
-	spi_transmit(txData, 2);
+	spi_transfer(txData, NULL, 2);
+	RC522_spi_cs_write(1);
+	RFID_TRACE(RFID_TRACE_WRITE, reg, data8);
+}
+
+// Function to end a DMA burst in the completion interrupt, chip-select goes up as soon as the last byte is in
+static void RC522_burst_done(int8_t status) {
+	RC522_spi_cs_write(1);
+	RC522_burst_status = status;
+}
+
+// Function to run one chip-select frame of a FIFO burst. Long bursts go through DMA and the core sleeps until the
+// completion interrupt instead of polling every byte, short ones cost less polled than the DMA set-up.
+static bool RC522_burst(const uint8_t *tx, uint8_t *rx, uint8_t size) {
+	int8_t status;
+
+	RC522_spi_cs_write(0);
+	if ((size >= MFRC522_DMA_MIN_BURST) && (spi_transfer_async(tx, rx, size, RC522_burst_done) == 0)) {
+		// With interrupts masked the completion interrupt still ends WFI, and cannot slip in before it
+		__disable_irq();
+		while (spi_transfer_busy()) {
+			__WFI();
+			__enable_irq();
+			__disable_irq();
+		}
+		__enable_irq();
+		return RC522_burst_status == 0;
+	}
+	status = spi_transfer(tx, rx, size);
 	RC522_spi_cs_write(1);
+	return status == 0;
+}
+
+// Function to write a block of bytes to the FIFO of the RC522 with a single address byte
+bool RC522_fifo_write_burst(const uint8_t *data, uint8_t len) {
+	bool status;
+
+	if (len > MFRC522_FIFO_SIZE) {
+		len = MFRC522_FIFO_SIZE;
+	}
+
+	RC522_burst_tx[0] = 0x7E & (MFRC522_REG_FIFO_DATA << 1);
+	memcpy(&RC522_burst_tx[1], data, len);
+
+	status = RC522_burst(RC522_burst_tx, NULL, len + 1);
+	RFID_TRACE(RFID_TRACE_FIFO_WRITE, MFRC522_REG_FIFO_DATA, len);
+
+	return status;
+}
+
+// Function to read a block of bytes from the FIFO of the RC522 while keeping CS asserted
+bool RC522_fifo_read_burst(uint8_t *data, uint8_t len) {
+	bool status;
+
+	if (len > MFRC522_FIFO_SIZE) {
+		len = MFRC522_FIFO_SIZE;
+	}
+
+	// Each address byte clocks out the data of the previous one, a trailing 0x00 ends the read
+	memset(RC522_burst_tx, ((MFRC522_REG_FIFO_DATA << 1) & 0x7E) | 0x80, len);
+	RC522_burst_tx[len] = 0x00;
+
+	status = RC522_burst(RC522_burst_tx, RC522_burst_rx, len + 1);
+	RFID_TRACE(RFID_TRACE_FIFO_READ, MFRC522_REG_FIFO_DATA, len);
+
+	if (!status) {
+		return false;
+	}
+	memcpy(data, &RC522_burst_rx[1], len);
+	return true;
+}
+
+// Function to load the timer that ends a transceive when the card does not answer
+static void RC522_set_timer_reload(uint16_t reload) {
+	RC522_reg_write8(MFRC522_REG_T_RELOAD_L, reload & 0xFF);
+	RC522_reg_write8(MFRC522_REG_T_RELOAD_H, reload >> 8);
 }
 
 // Function to set a specific bit in a register of the RC522
@@ -98,9 +388,15 @@ void RC522_clear_bit(uint8_t reg, uint8_t mask) {
 	RC522_reg_write8(reg, RC522_reg_read8(reg) & (~mask));
 }
 
+// Function to drop all shadowed register values
+void RC522_shadow_invalidate(void) {
+	RC522_shadow_valid = 0;
+}
+
 // Function to reset the RC522
 void RC522_reset(void) {
 	RC522_reg_write8(0x01, 0x0F);
+	RC522_shadow_invalidate();	// Soft reset restores the reset value of every register
 }
 
 // Function to turn on the antenna for the RC522
@@ -113,34 +409,334 @@ void RC522_antenna_ON(void) {
 	}
 }
 
+// Function to start an IRQ driven request when none is running, or check the one started by an earlier call
+static bool RC522_request_irq_step(uint8_t reqMode, uint8_t *tagType) {
+	if (!RC522_irq_request_active) {
+		RC522_request_irq_start(reqMode);
+		return false;
+	}
+	return RC522_request_irq_poll(tagType) == RC522_REQUEST_CARD;
+}
+
 // Function to check for an RFID card and retrieve its UID
-bool RC522_check_card(uint8_t *id) {
+bool RC522_check_card(RC522_uid_t *uid) {
 	bool status = false;
+	uint8_t atqa[MFRC522_MAX_LEN];
 	// Find cards if tapped against receiver
-	status = RC522_request(PICC_REQIDL, id);
+	if (RC522_irq_mode) {
+		status = RC522_request_irq_step(PICC_REQIDL, atqa);
+	} else {
+		status = RC522_request(PICC_REQIDL, atqa);
+	}
 	if (status == true) {
 		// If card is detected, Card detected
-		// Return card UID 4 bytes
-		status = RC522_anti_coll(id);
+		// Return card UID 4, 7 or 10 bytes
+		status = RC522_select(uid);
+		RC522_halt();      // Command card into hibernation
 	}
-	RC522_halt();      // Command card into hibernation
 
 	return status;
 }
 
+// Function to read and halt the cards in the field once one of them has answered a request
+static uint8_t RC522_inventory_resolve(RC522_uid_t *uids, uint8_t maxCards) {
+	uint8_t atqa[MFRC522_MAX_LEN];
+	uint8_t count = 0;
+	uint8_t failures = 0;
+
+	do {
+		if (RC522_select(&uids[count])) {
+			count++;
+		} else {
+			failures++;
+		}
+		RC522_halt();      // Command card into hibernation
+
+		// Only cards that are not halted yet answer
+	} while ((count < maxCards) && (failures <= MFRC522_INVENTORY_RETRIES)
+			&& RC522_request(PICC_REQIDL, atqa));
+
+	return count;
+}
+
+// Function to collect the UIDs of all cards in the field, halting each one once it is read
+uint8_t RC522_inventory(uint8_t reqMode, RC522_uid_t *uids, uint8_t maxCards) {
+	uint8_t atqa[MFRC522_MAX_LEN];
+	bool status;
+
+	if (maxCards == 0) {
+		return 0;
+	}
+
+	// The first request completes on the IRQ line over several calls
+	if (RC522_irq_mode) {
+		status = RC522_request_irq_step(reqMode, atqa);
+	} else {
+		status = RC522_request(reqMode, atqa);
+	}
+	if (!status) {
+		return 0;
+	}
+
+	return RC522_inventory_resolve(uids, maxCards);
+}
+
+// Function to set how long a card may go unseen before it counts as removed
+void RC522_set_hold_off(uint32_t hold_off_ms) {
+	RC522_hold_off_ms = hold_off_ms;
+}
+
+// Function to compare two UIDs
+static bool RC522_uid_equal(const RC522_uid_t *a, const RC522_uid_t *b) {
+	return (a->size == b->size) && (memcmp(a->uid, b->uid, a->size) == 0);
+}
+
+// Function to read the field and turn it into presented and removed events through the recently-seen cache
+uint8_t RC522_poll_events(RC522_event_t *events, uint8_t maxEvents) {
+	RC522_uid_t cards[MFRC522_INVENTORY_MAX];
+	RC522_seen_entry_t *entry;
+	uint8_t count;
+	uint8_t found = 0;
+	uint8_t c;
+	uint8_t j;
+	uint32_t now;
+
+	// Halted cards still on the reader have to answer too, otherwise they would look removed
+#ifdef MFRC522_LPCD_ENABLE
+	count = RC522_lpcd_poll(cards, MFRC522_INVENTORY_MAX);	// The field is off between slots, every card restarts idle
+#else
+	count = RC522_inventory(PICC_REQALL, cards, MFRC522_INVENTORY_MAX);
+#endif
+	now = millis();
+
+	for (c = 0; c < count; c++) {
+		entry = NULL;
+		for (j = 0; j < MFRC522_SEEN_CACHE_SIZE; j++) {
+			if (RC522_seen[j].used && RC522_uid_equal(&RC522_seen[j].uid, &cards[c])) {
+				entry = &RC522_seen[j];
+				break;
+			}
+		}
+		if (entry != NULL) {
+			entry->last_seen = now;	// Still held on the reader
+			continue;
+		}
+		if (found == maxEvents) {
+			continue;	// Not cached, so it is reported by the next call
+		}
+
+		// New card, take a free entry or the one not seen for the longest time
+		entry = &RC522_seen[0];
+		for (j = 0; j < MFRC522_SEEN_CACHE_SIZE; j++) {
+			if (!RC522_seen[j].used) {
+				entry = &RC522_seen[j];
+				break;
+			}
+			if ((int32_t) (RC522_seen[j].last_seen - entry->last_seen) < 0) {
+				entry = &RC522_seen[j];
+			}
+		}
+		entry->used = true;
+		entry->last_seen = now;
+		entry->uid = cards[c];
+		events[found].type = RC522_EVENT_PRESENTED;
+		events[found].uid = cards[c];
+		found++;
+	}
+
+	for (j = 0; (j < MFRC522_SEEN_CACHE_SIZE) && (found < maxEvents); j++) {
+		if (RC522_seen[j].used && (now - RC522_seen[j].last_seen >= RC522_hold_off_ms)) {
+			RC522_seen[j].used = false;
+			events[found].type = RC522_EVENT_REMOVED;
+			events[found].uid = RC522_seen[j].uid;
+			found++;
+		}
+	}
+
+	return found;
+}
+
+// Function to check whether a card is on the reader or a request is waiting for one
+bool RC522_field_busy(void) {
+	uint8_t j;
+
+	if (RC522_irq_request_active || RC522_irq_flag) {
+		return true;
+	}
+	for (j = 0; j < MFRC522_SEEN_CACHE_SIZE; j++) {
+		if (RC522_seen[j].used) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Function to enter soft power-down
+void RC522_power_down(void) {
+	RC522_reg_write8(MFRC522_REG_COMMAND, 0x10 | PCD_IDLE); // PowerDown = 1
+}
+
+// Function to leave soft power-down, the PowerDown bit reads 1 until the RC522 is ready
+bool RC522_power_up(void) {
+	uint32_t start;
+	uint32_t timeout = cycles_from_us(MFRC522_POWER_UP_TIMEOUT_US);
+	bool done;
+
+	RC522_reg_write8(MFRC522_REG_COMMAND, PCD_IDLE);
+	start = cycles();
+	do {
+		done = !(RC522_reg_read8(MFRC522_REG_COMMAND) & 0x10);
+	} while (!done && (cycles() - start < timeout));
+
+	return done;
+}
+
+// Function to set the period of the detection slots
+void RC522_lpcd_set_interval(uint32_t interval_ms) {
+	RC522_lpcd_stats.interval_ms = interval_ms;
+}
+
+// Function to run a detection slot once it is due, the RC522 stays in power-down in between
+uint8_t RC522_lpcd_poll(RC522_uid_t *uids, uint8_t maxCards) {
+	uint8_t atqa[MFRC522_MAX_LEN];
+	uint32_t start;
+	uint32_t active_us;
+	bool status;
+
+	// Not due yet, the caller sleeps until the next slot
+	if ((int32_t) (RC522_lpcd_next_slot - millis()) > 0) {
+		return 0;
+	}
+
+	// Field on and give the cards time to power up
+	start = cycles();
+	RC522_power_up();
+	while (cycles() - start < cycles_from_us(MFRC522_LPCD_FIELD_SETTLE_US)) {
+	}
+
+	// Presence check, the REQA runs with the short timer
+	status = (maxCards != 0) && RC522_request(PICC_REQIDL, atqa);
+	RC522_lpcd_stats.slots++;
+
+	if (status) {
+		RC522_lpcd_stats.detections++;
+		RC522_lpcd_next_slot = millis();
+		return RC522_inventory_resolve(uids, maxCards);
+	}
+
+	RC522_power_down();
+	active_us = cycles_to_us(cycles() - start);
+	RC522_lpcd_stats.active_us_last = active_us;
+	RC522_lpcd_stats.active_us_sum += active_us;
+	RC522_lpcd_stats.empty_slots++;
+	if (active_us > RC522_lpcd_stats.active_us_max) {
+		RC522_lpcd_stats.active_us_max = active_us;
+	}
+
+	// Schedule the next slot on the interval grid
+	RC522_lpcd_next_slot += RC522_lpcd_stats.interval_ms;
+	if (((int32_t) (RC522_lpcd_next_slot - millis()) <= 0)
+			|| ((int32_t) (RC522_lpcd_next_slot - millis()) > (int32_t) RC522_lpcd_stats.interval_ms)) {
+		RC522_lpcd_next_slot = millis() + RC522_lpcd_stats.interval_ms; // Slot overrun or interval changed
+	}
+
+	return 0;
+}
+
+// Function to estimate the average current from the mean slot length and the detection latency from the longest
+const RC522_lpcd_stats_t* RC522_lpcd_get_stats(void) {
+	uint64_t interval_us = (uint64_t) RC522_lpcd_stats.interval_ms * 1000;
+	uint64_t period_us = interval_us;
+	uint64_t active_us = 0;
+	uint64_t max_us = RC522_lpcd_stats.active_us_max;
+	uint64_t charge;
+
+	if (RC522_lpcd_stats.empty_slots != 0) {
+		active_us = RC522_lpcd_stats.active_us_sum / RC522_lpcd_stats.empty_slots;
+	}
+	if (active_us > period_us) {
+		period_us = active_us;
+	}
+
+	if (period_us != 0) {
+		charge = active_us * (MFRC522_ACTIVE_UA + MCU_RUN_UA)
+				+ (period_us - active_us) * (MFRC522_PDOWN_UA + MCU_SLEEP_UA);
+		RC522_lpcd_stats.avg_current_ua = charge / period_us;
+	}
+
+	// A card arriving just after a presence check waits a full slot and is seen at the end of the next check
+	if (max_us > interval_us) {
+		interval_us = max_us;
+	}
+	RC522_lpcd_stats.worst_latency_ms = (interval_us + max_us + 999) / 1000;
+
+	return &RC522_lpcd_stats;
+}
+
 // Function to request the RFID card and get its tag type
 bool RC522_request(uint8_t reqMode, uint8_t *tagType) {
 	bool status = false;
 	uint16_t backBits;
+	RFID_TRACE(RFID_TRACE_BEGIN, RFID_TRACE_ID_REQUEST, reqMode);
+	RC522_set_timer_reload(MFRC522_SHORT_RELOAD); // An empty field only costs the ATQA window
 	RC522_reg_write8(MFRC522_REG_BIT_FRAMING, 0x07);
 	tagType[0] = reqMode;
 	status = RC522_to_card(PCD_TRANSCEIVE, tagType, 1, tagType, &backBits);
+	if ((status != true) && (RC522_get_last_error() == MFRC522_ERR_COLL)) {
+		status = true;	// Several cards answered, anti-collision picks one of them
+	}
 	if ((status != true) || (backBits != 0x10)) {
 		status = false;
 	}
+	RFID_TRACE(RFID_TRACE_END, RFID_TRACE_ID_REQUEST, status);
 	return status;
 }
 
+// Function to send a request to the RFID card and return, the RC522 IRQ reports the answer or a timeout
+bool RC522_request_irq_start(uint8_t reqMode) {
+	RC522_reg_write8(MFRC522_REG_COMMAND, PCD_IDLE);
+	RC522_set_timer_reload(MFRC522_SHORT_RELOAD);
+	RC522_reg_write8(MFRC522_REG_BIT_FRAMING, 0x07);
+	RC522_reg_write8(MFRC522_REG_COMM_IE_N, 0x80 | 0x20 | 0x01); // IRqInv, RxIEn, TimerIEn
+	RC522_reg_write8(MFRC522_REG_COMM_IRQ, 0x7F); // Set1=0, clear all interrupt request bits
+	RC522_reg_write8(MFRC522_REG_FIFO_LEVEL, 0x80); // Flush the FIFO
+
+	RC522_irq_flag = false;
+	if (!RC522_fifo_write_burst(&reqMode, 1)) {
+		return false;
+	}
+	RC522_reg_write8(MFRC522_REG_COMMAND, PCD_TRANSCEIVE);
+	RC522_set_bit(MFRC522_REG_BIT_FRAMING, 0x80); // StartSend=1, transmission of data starts
+
+	RC522_irq_request_start = millis();
+	RC522_irq_request_active = true;
+	return true;
+}
+
+// Function to check whether the RxIRq or TimerIRq edge of the running request has arrived
+RC522_request_state_t RC522_request_irq_poll(uint8_t *tagType) {
+	uint8_t n;
+
+	if (!RC522_irq_request_active) {
+		return RC522_REQUEST_NO_CARD;
+	}
+	if (!RC522_irq_flag && (millis() - RC522_irq_request_start < MFRC522_IRQ_TIMEOUT_MS)) {
+		return RC522_REQUEST_PENDING;
+	}
+	RC522_irq_request_active = false;
+
+	RC522_clear_bit(MFRC522_REG_BIT_FRAMING, 0x80); // StartSend=0
+	n = RC522_reg_read8(MFRC522_REG_COMM_IRQ);
+
+	// Only a two byte ATQA means a card is present, colliding ATQAs of several cards included
+	if (!(n & 0x20) || (RC522_reg_read8(MFRC522_REG_ERROR) & 0x13)
+			|| (RC522_reg_read8(MFRC522_REG_FIFO_LEVEL) != 2)
+			|| !RC522_fifo_read_burst(tagType, 2)) {
+		return RC522_REQUEST_NO_CARD;
+	}
+	return RC522_REQUEST_CARD;
+}
+
 // Function to transmit data to the RFID card and receive its response
 bool RC522_to_card(uint8_t command, uint8_t *sendData, uint8_t sendLen,
 		uint8_t *backData, uint16_t *backLen) {
@@ -149,20 +745,24 @@ bool RC522_to_card(uint8_t command, uint8_t *sendData, uint8_t sendLen,
 	uint8_t waitIRq = 0x00;
 	uint8_t lastBits;
 	uint8_t n;
-	uint16_t i;
+	uint16_t polls = 0;
+	bool done;
+	uint32_t start;
+	uint32_t timeout;
 
+	RC522_last_error = 0;
 	irqEn = 0x77;
 	waitIRq = 0x30;
 
 	RC522_reg_write8(MFRC522_REG_COMM_IE_N, irqEn | 0x80);
-	RC522_clear_bit(MFRC522_REG_COMM_IRQ, 0x80);
-	RC522_set_bit(MFRC522_REG_FIFO_LEVEL, 0x80);
+	RC522_reg_write8(MFRC522_REG_COMM_IRQ, 0x7F); // Set1=0, clear all interrupt request bits
+	RC522_reg_write8(MFRC522_REG_FIFO_LEVEL, 0x80); // FlushBuffer=1, the other bits are read-only
 
 	RC522_reg_write8(MFRC522_REG_COMMAND, PCD_IDLE);
 
 	// Writing data to the FIFO
-	for (i = 0; i < sendLen; i++) {
-		RC522_reg_write8(MFRC522_REG_FIFO_DATA, sendData[i]);
+	if (!RC522_fifo_write_burst(sendData, sendLen)) {
+		return false;
 	}
 
 	// Execute the command
@@ -171,20 +771,26 @@ bool RC522_to_card(uint8_t command, uint8_t *sendData, uint8_t sendLen,
 		RC522_set_bit(MFRC522_REG_BIT_FRAMING, 0x80); // StartSend=1, transmission of data starts
 	}
 
-	// Waiting to receive data to complete
-	i = 100; // i according to the clock frequency adjustment, the operator M1 card maximum waiting time 25ms???
+	// Waiting to receive data to complete, bounded by the deadline of the command
+	start = cycles();
+	timeout = cycles_from_us(RC522_timing[command & 0x0F].timeout_us);
 	do {
 		// CommIrqReg[7..0]
 		// Set1 TxIRq RxIRq IdleIRq HiAlerIRq LoAlertIRq ErrIRq TimerIRq
 		n = RC522_reg_read8(MFRC522_REG_COMM_IRQ);
-		i--;
-	} while ((i != 0) && !(n & 0x01) && !(n & waitIRq));
+		polls++;
+		done = (n & 0x01) || (n & waitIRq);
+	} while (!done && (cycles() - start < timeout));
+	RC522_record_polls(command, polls, done);
 
 	RC522_clear_bit(MFRC522_REG_BIT_FRAMING, 0x80);     // StartSend=0
 
-	if (i != 0) {
-		if (!(RC522_reg_read8(MFRC522_REG_ERROR) & 0x1B)) {
-			status = true;
+	if (done) {
+		RC522_last_error = RC522_reg_read8(MFRC522_REG_ERROR)
+				& (MFRC522_ERR_BUFFER_OVFL | MFRC522_ERR_COLL | MFRC522_ERR_PARITY | MFRC522_ERR_PROTOCOL);
+		// A bit collision still leaves the bits received before it in the FIFO for the anti-collision loop
+		if (!(RC522_last_error & ~MFRC522_ERR_COLL)) {
+			status = !RC522_last_error;
 			if (n & irqEn & 0x01) {
 				status = false;
 			}
@@ -207,18 +813,17 @@ bool RC522_to_card(uint8_t command, uint8_t *sendData, uint8_t sendLen,
 				}
 
 				// Reading the received data in FIFO
-				for (i = 0; i < n; i++) {
-					uint8_t d = RC522_reg_read8(MFRC522_REG_FIFO_DATA);
-					if (l == 4)
-						printf("%02x ", d);
-					backData[i] = d;
+				if (!RC522_fifo_read_burst(backData, n)) {
+					return false;
+				}
+				if (l == 4) {
+					debug_log(DEBUG_LOG_RC522_RX4, ((uint32_t) backData[0] << 24) | ((uint32_t) backData[1] << 16)
+							| ((uint32_t) backData[2] << 8) | backData[3], 0);
 				}
-				if (l == 4)
-					printf("\r\n");
 				return status;
 			}
 		} else {
-			printf("error\r\n");
+			debug_log(DEBUG_LOG_RC522_ERROR, RC522_last_error, command);
 			status = false;
 		}
 	}
@@ -226,62 +831,295 @@ bool RC522_to_card(uint8_t command, uint8_t *sendData, uint8_t sendLen,
 	return status;
 }
 
-// Function to acquire the UID of the RFID card 
-bool RC522_anti_coll(uint8_t *serNum) {
-	bool status;
+// Function to get the error flags of the last command sent to the card
+uint8_t RC522_get_last_error(void) {
+	return RC522_last_error;
+}
+
+// Function to acquire the UID part and SAK of one cascade level
+static bool RC522_anti_coll_level(uint8_t selCmd, uint8_t *serNum, uint8_t *sak) {
+	// SEL, NVB, UID0..UID3, BCC, CRC_A
+	uint8_t buff[9] = { 0 };
+	uint8_t back[MFRC522_MAX_LEN];
+	uint8_t knownBits = 0;
+	uint8_t index;
+	uint8_t txLastBits;
+	uint8_t collPos;
 	uint8_t i;
-	uint8_t serNumCheck = 0;
 	uint16_t unLen;
+	bool status;
 
-	RC522_reg_write8(MFRC522_REG_BIT_FRAMING, 0x00); // TxLastBists = BitFramingReg[2..0]
+	buff[0] = selCmd;
+	RC522_set_timer_reload(MFRC522_SHORT_RELOAD); // A card that left the field is noticed within 1ms
+	RC522_clear_bit(MFRC522_REG_COLL, 0x80); // ValuesAfterColl = 0, bits received after a collision are cleared
 
-	serNum[0] = PICC_ANTICOLL;
-	serNum[1] = 0x20;
-	status = RC522_to_card(PCD_TRANSCEIVE, serNum, 2, serNum, &unLen);
+	// Each collision fixes one more UID bit, so the loop ends after at most 32 rounds
+	while (knownBits < 32) {
+		index = 2 + knownBits / 8;
+		txLastBits = knownBits % 8;
+		buff[1] = (index << 4) | txLastBits; // NVB, number of valid bytes and bits sent
 
-	if (status == true) {
-		// Check card serial number
-		for (i = 0; i < 4; i++) {
-			serNumCheck ^= serNum[i];
+		// The card answers with the remaining bits, aligned after the last bit sent
+		RC522_reg_write8(MFRC522_REG_BIT_FRAMING, (txLastBits << 4) | txLastBits); // RxAlign, TxLastBits
+		status = RC522_to_card(PCD_TRANSCEIVE, buff, index + (txLastBits ? 1 : 0), back, &unLen);
+		if ((status != true) && (RC522_get_last_error() != MFRC522_ERR_COLL)) {
+			return false;
 		}
-		if (serNumCheck != serNum[i]) {
-			status = false;
+
+		// Merge the answer, the first byte only completes the bits not sent
+		buff[index] = (buff[index] & ~(0xFF << txLastBits)) | (back[0] & (0xFF << txLastBits));
+		for (i = 1; (index + i < 7) && (i < MFRC522_MAX_LEN); i++) {
+			buff[index + i] = back[i];
+		}
+
+		if (status == true) {
+			break;
+		}
+
+		collPos = RC522_reg_read8(MFRC522_REG_COLL);
+		if (collPos & 0x20) { // CollPosNotValid
+			return false;
 		}
+		collPos &= 0x1F;
+		if (collPos == 0) {
+			collPos = 32;
+		}
+
+		// CollPos counts from the first bit received in this round
+		collPos += knownBits;
+		if (collPos > 32) {
+			return false;
+		}
+
+		// Follow the 1 branch of the collided bit
+		knownBits = collPos;
+		buff[2 + (knownBits - 1) / 8] |= 1 << ((knownBits - 1) % 8);
+	}
+
+	RC522_reg_write8(MFRC522_REG_BIT_FRAMING, 0x00);
+
+	// A collision on the last UID bit ends the loop before the BCC is received
+	if (knownBits == 32) {
+		buff[6] = buff[2] ^ buff[3] ^ buff[4] ^ buff[5];
+	}
+
+	// Check card serial number
+	if ((buff[2] ^ buff[3] ^ buff[4] ^ buff[5]) != buff[6]) {
+		return false;
 	}
+
+	// SELECT the card, it answers with SAK and CRC_A
+	buff[1] = 0x70;
+	RC522_crc_a(buff, 7, &buff[7]);
+	status = RC522_to_card(PCD_TRANSCEIVE, buff, 9, back, &unLen);
+	if ((status != true) || (unLen != 24)) {
+		return false;
+	}
+	RC522_crc_a(back, 1, &buff[7]);
+	if ((back[1] != buff[7]) || (back[2] != buff[8])) {
+		return false;
+	}
+
+	memcpy(serNum, &buff[2], 4);
+	*sak = back[0];
+	return true;
+}
+
+// Function to run the anti-collision and select of one cascade level
+bool RC522_anti_coll(uint8_t selCmd, uint8_t *serNum, uint8_t *sak) {
+	bool status;
+
+	RFID_TRACE(RFID_TRACE_BEGIN, RFID_TRACE_ID_ANTI_COLL, selCmd);
+	status = RC522_anti_coll_level(selCmd, serNum, sak);
+	RFID_TRACE(RFID_TRACE_END, RFID_TRACE_ID_ANTI_COLL, status);
 	return status;
 }
 
+// Function to walk the cascade levels and collect the complete UID of one card
+bool RC522_select(RC522_uid_t *uid) {
+	static const uint8_t selCmd[MFRC522_CASCADE_LEVELS] = { PICC_ANTICOLL, PICC_SEL_CL2, PICC_SEL_CL3 };
+	uint8_t serNum[4];
+	uint8_t level;
+
+	uid->size = 0;
+	for (level = 0; level < MFRC522_CASCADE_LEVELS; level++) {
+		if (!RC522_anti_coll(selCmd[level], serNum, &uid->sak)) {
+			return false;
+		}
+
+		// The cascade bit announces another level, this one starts with the cascade tag
+		if (uid->sak & PICC_SAK_CASCADE) {
+			if ((serNum[0] != PICC_CASCADE_TAG) || (level == MFRC522_CASCADE_LEVELS - 1)) {
+				return false;
+			}
+			memcpy(&uid->uid[uid->size], &serNum[1], 3);
+			uid->size += 3;
+		} else {
+			memcpy(&uid->uid[uid->size], serNum, 4);
+			uid->size += 4;
+			return true;
+		}
+	}
+	return false;
+}
+
 // Function to put the RFID card reader into hibernation until the card has been processed
 void RC522_halt(void) {
 	uint16_t unLen;
-	uint8_t buff[4];
+	uint8_t buff[MFRC522_MAX_LEN];	// RC522_to_card() may read up to MFRC522_MAX_LEN bytes back
 
+	RFID_TRACE(RFID_TRACE_BEGIN, RFID_TRACE_ID_HALT, PICC_HALT);
 	buff[0] = PICC_HALT;
 	buff[1] = 0;
-	RC522_calculate_CRC(buff, 2, &buff[2]);
+	RC522_crc_a(buff, 2, &buff[2]);
+	RC522_set_timer_reload(MFRC522_SHORT_RELOAD); // Silence for 1ms means the card accepted the HLTA
 
 	RC522_to_card(PCD_TRANSCEIVE, buff, 4, buff, &unLen);
+	RFID_TRACE(RFID_TRACE_END, RFID_TRACE_ID_HALT, 0);
+}
+
+// Function to authenticate a sector, the RC522 runs the three pass Crypto1 handshake
+bool RC522_auth(uint8_t authMode, uint8_t blockAddr, const uint8_t *key,
+		const RC522_uid_t *uid) {
+	uint8_t buff[12];
+	uint16_t unLen;
+
+	// Auth command, block address, sector key and the last 4 UID bytes
+	buff[0] = authMode;
+	buff[1] = blockAddr;
+	memcpy(&buff[2], key, MIFARE_KEY_SIZE);
+	memcpy(&buff[8], &uid->uid[uid->size - 4], 4);
+
+	RC522_set_timer_reload(MFRC522_TIMER_RELOAD);
+	if (!RC522_to_card(PCD_AUTHENT, buff, 12, buff, &unLen)) {
+		return false;
+	}
+	return RC522_reg_read8(MFRC522_REG_STATUS2) & 0x08; // MFCrypto1On
+}
+
+// Function to read a block, the card answers with 16 data bytes and their CRC_A
+bool RC522_read_block(uint8_t blockAddr, uint8_t *data) {
+	uint8_t buff[MFRC522_MAX_LEN];
+	uint8_t crc[2];
+	uint16_t unLen;
+
+	buff[0] = PICC_READ;
+	buff[1] = blockAddr;
+	RC522_crc_a(buff, 2, &buff[2]);
+
+	RC522_set_timer_reload(MFRC522_TIMER_RELOAD);
+	if (!RC522_to_card(PCD_TRANSCEIVE, buff, 4, buff, &unLen)
+			|| (unLen != (MIFARE_BLOCK_SIZE + 2) * 8)) {
+		return false;
+	}
+
+	RC522_crc_a(buff, MIFARE_BLOCK_SIZE, crc);
+	if ((buff[MIFARE_BLOCK_SIZE] != crc[0]) || (buff[MIFARE_BLOCK_SIZE + 1] != crc[1])) {
+		return false;
+	}
+
+	memcpy(data, buff, MIFARE_BLOCK_SIZE);
+	return true;
+}
+
+// Function to check for the 4 bit MIFARE ACK after a frame sent to the card
+static bool RC522_mifare_transceive(uint8_t *sendData, uint8_t sendLen) {
+	uint8_t back[MFRC522_MAX_LEN];
+	uint16_t unLen;
+
+	RC522_set_timer_reload(MFRC522_TIMER_RELOAD);
+	if (!RC522_to_card(PCD_TRANSCEIVE, sendData, sendLen, back, &unLen)) {
+		return false;
+	}
+	return (unLen == 4) && ((back[0] & 0x0F) == PICC_ACK);
+}
+
+// Function to write a block, command and data are acknowledged separately
+bool RC522_write_block(uint8_t blockAddr, const uint8_t *data) {
+	uint8_t buff[MFRC522_MAX_LEN];
+
+	buff[0] = PICC_WRITE;
+	buff[1] = blockAddr;
+	RC522_crc_a(buff, 2, &buff[2]);
+	if (!RC522_mifare_transceive(buff, 4)) {
+		return false;
+	}
+
+	memcpy(buff, data, MIFARE_BLOCK_SIZE);
+	RC522_crc_a(buff, MIFARE_BLOCK_SIZE, &buff[MIFARE_BLOCK_SIZE]);
+	return RC522_mifare_transceive(buff, MIFARE_BLOCK_SIZE + 2);
+}
+
+// Function to leave the authenticated state
+void RC522_stop_crypto1(void) {
+	RC522_clear_bit(MFRC522_REG_STATUS2, 0x08); // MFCrypto1On = 0
+}
+
+// Function to calculate the CRC_A of a frame in software, one table lookup per byte
+void RC522_crc_a(const uint8_t *pIndata, uint8_t len, uint8_t *pOutData) {
+	uint16_t crc = CRC_A_PRESET;
+
+	while (len--) {
+		crc = (crc >> 8) ^ RC522_crc_a_table[(crc ^ *pIndata++) & 0xFF];
+	}
+
+	pOutData[0] = crc & 0xFF;
+	pOutData[1] = crc >> 8;
+}
+
+// Function to compare the software CRC_A with the RC522 coprocessor
+bool RC522_crc_self_test(void) {
+	// HLTA, SELECT CL1, READ block 4 and a full 16 byte payload
+	static const uint8_t frames[][16] = {
+		{ PICC_HALT, 0x00 },
+		{ PICC_ANTICOLL, 0x70, 0xE3, 0x9A, 0x9F, 0x0B, 0xDD },
+		{ 0x30, 0x04 },
+		{ 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA,
+				0xBB, 0xCC, 0xDD, 0xEE, 0xFF },
+	};
+	static const uint8_t lengths[] = { 2, 7, 2, 16 };
+	uint8_t sw[2];
+	uint8_t hw[2];
+	uint8_t i;
+
+	for (i = 0; i < sizeof(lengths); i++) {
+		RC522_crc_a(frames[i], lengths[i], sw);
+		RC522_calculate_CRC((uint8_t*) frames[i], lengths[i], hw);
+		if ((sw[0] != hw[0]) || (sw[1] != hw[1])) {
+			return false;
+		}
+	}
+	return true;
 }
 
 // Function to calculate the CRC for RFID card communication
 void RC522_calculate_CRC(uint8_t *pIndata, uint8_t len, uint8_t *pOutData) {
-	uint8_t i, n;
+	uint8_t n;
+	uint16_t polls = 0;
+	bool done;
+	uint32_t start;
+	uint32_t timeout;
 
-	RC522_clear_bit(MFRC522_REG_DIV_IRQ, 0x04);     // CRCIrq = 0
-	RC522_set_bit(MFRC522_REG_FIFO_LEVEL, 0x80);      // Clear the FIFO pointer
+	RC522_reg_write8(MFRC522_REG_DIV_IRQ, 0x04);     // Set2=0, CRCIrq = 0
+	RC522_reg_write8(MFRC522_REG_FIFO_LEVEL, 0x80);      // Clear the FIFO pointer
 
-	// Writing data to the FIFO
-	for (i = 0; i < len; i++) {
-		RC522_reg_write8(MFRC522_REG_FIFO_DATA, *(pIndata + i));
+	// Writing data to the FIFO, the command is not started if the burst failed
+	if (!RC522_fifo_write_burst(pIndata, len)) {
+		pOutData[0] = 0;
+		pOutData[1] = 0;
+		return;
 	}
 	RC522_reg_write8(MFRC522_REG_COMMAND, PCD_CALCCRC);
 
 	// Wait CRC calculation is complete
-	i = 0xFF;
+	start = cycles();
+	timeout = cycles_from_us(RC522_timing[PCD_CALCCRC].timeout_us);
 	do {
 		n = RC522_reg_read8(MFRC522_REG_DIV_IRQ);
-		i--;
-	} while ((i != 0) && !(n & 0x04));      // CRCIrq = 1
+		polls++;
+		done = n & 0x04;      // CRCIrq = 1
+	} while (!done && (cycles() - start < timeout));
+	RC522_record_polls(PCD_CALCCRC, polls, done);
 
 	// Read CRC calculation result
 	pOutData[0] = RC522_reg_read8(MFRC522_REG_CRC_RESULT_L);
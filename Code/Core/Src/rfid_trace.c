@@ -0,0 +1,75 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   rfid_trace.c
+* @brief  A file defining the RC522 register access tracer.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 8, 2023
+* @revision 1.0
+*
+*/
+
+#include <stdio.h>
+#include "rfid_trace.h"
+#include "delay.h"
+
+static rfid_trace_entry_t rfid_trace_buffer[RFID_TRACE_SIZE];
+static uint32_t rfid_trace_head = 0;	// Total entries recorded, the next one goes to head % RFID_TRACE_SIZE
+
+// Function to record one event with the current cycle count
+void rfid_trace_record(uint8_t type, uint8_t reg, uint8_t value) {
+	rfid_trace_entry_t *entry;
+	rfid_trace_entry_t *first;
+
+	// Fold a poll into the second entry of the run so waits do not flush the buffer
+	if ((type == RFID_TRACE_READ) && (rfid_trace_head >= 2)) {
+		entry = &rfid_trace_buffer[(rfid_trace_head - 1) & (RFID_TRACE_SIZE - 1)];
+		first = &rfid_trace_buffer[(rfid_trace_head - 2) & (RFID_TRACE_SIZE - 1)];
+		if ((entry->type == type) && (entry->reg == reg) && (entry->value == value)
+				&& (first->type == type) && (first->reg == reg) && (first->value == value)
+				&& (entry->repeat < UINT8_MAX)) {
+			entry->cycles = cycles();
+			entry->repeat++;
+			return;
+		}
+	}
+
+	entry = &rfid_trace_buffer[rfid_trace_head & (RFID_TRACE_SIZE - 1)];
+	entry->cycles = cycles();
+	entry->type = type;
+	entry->reg = reg;
+	entry->value = value;
+	entry->repeat = 0;
+	rfid_trace_head++;
+}
+
+// Function to drop all the recorded events
+void rfid_trace_clear(void) {
+	rfid_trace_head = 0;
+}
+
+// Function to print the recorded events, oldest first
+void rfid_trace_dump(void (*write)(char *text)) {
+	char line[40];
+	uint32_t count = rfid_trace_head < RFID_TRACE_SIZE ? rfid_trace_head : RFID_TRACE_SIZE;
+	uint32_t i;
+
+	sprintf(line, "TRACE %lu %lu\r\n", (unsigned long) count, (unsigned long) cycles_from_us(1));
+	write(line);
+	for (i = rfid_trace_head - count; i != rfid_trace_head; i++) {
+		const rfid_trace_entry_t *entry = &rfid_trace_buffer[i & (RFID_TRACE_SIZE - 1)];
+		sprintf(line, "%08lx %02x %02x %02x %02x\r\n", (unsigned long) entry->cycles, entry->type,
+				entry->reg, entry->value, entry->repeat);
+		write(line);
+	}
+	write("END\r\n");
+}
@@ -0,0 +1,174 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   scheduler.c
+* @brief  A file defining the cooperative run-to-completion scheduler of the main loop.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 16, 2023
+* @revision 1.0
+*
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "stm32f4xx.h"
+#include "scheduler.h"
+#include "delay.h"
+
+/* One task */
+typedef struct {
+	void (*run)(void);
+	uint32_t release_ms;	// Next release of a periodic task
+	scheduler_task_stats_t stats;
+} scheduler_task_t;
+
+static scheduler_task_t scheduler_tasks[SCHEDULER_MAX_TASKS];
+static uint8_t scheduler_count = 0;
+static uint8_t scheduler_next_background = 0;	// Background tasks take turns
+static uint8_t scheduler_background_count = 0;
+static uint8_t scheduler_background_runs = 0;	// Background runs in the current millisecond
+static uint32_t scheduler_background_ms = 0;
+
+// Function to add a task
+int8_t scheduler_add(const char *name, void (*run)(void), uint32_t period_ms, uint8_t priority) {
+	scheduler_task_t *task;
+
+	if (scheduler_count >= SCHEDULER_MAX_TASKS) {
+		return -1;
+	}
+
+	task = &scheduler_tasks[scheduler_count];
+	memset(task, 0, sizeof(*task));
+	task->run = run;
+	task->release_ms = millis();
+	task->stats.name = name;
+	task->stats.period_ms = period_ms;
+	task->stats.priority = priority;
+	if (period_ms == SCHEDULER_BACKGROUND) {
+		scheduler_background_count++;
+	}
+	return scheduler_count++;
+}
+
+// Function to run a task to completion and account for its run time
+static void scheduler_execute(scheduler_task_t *task) {
+	uint32_t start = cycles();
+	uint32_t elapsed;
+
+	task->run();
+	elapsed = cycles() - start;
+
+	task->stats.runs++;
+	task->stats.total_cycles += elapsed;
+	if (elapsed > task->stats.max_cycles) {
+		task->stats.max_cycles = elapsed;
+	}
+}
+
+// Function to get the most urgent released periodic task
+static scheduler_task_t* scheduler_released(uint32_t now) {
+	scheduler_task_t *best = NULL;
+	uint8_t t;
+
+	for (t = 0; t < scheduler_count; t++) {
+		if ((scheduler_tasks[t].stats.period_ms != SCHEDULER_BACKGROUND)
+				&& ((int32_t) (now - scheduler_tasks[t].release_ms) >= 0)
+				&& ((best == NULL) || (scheduler_tasks[t].stats.priority < best->stats.priority))) {
+			best = &scheduler_tasks[t];
+		}
+	}
+	return best;
+}
+
+// Function to run the most urgent released task, or the next background task
+bool scheduler_run_once(void) {
+	uint32_t now = millis();
+	scheduler_task_t *task = scheduler_released(now);
+	uint32_t late;
+	uint8_t n;
+
+	if (task) {
+		// Releases stay on the period grid, a task more than a period behind skips the missed ones
+		task->release_ms += task->stats.period_ms;
+		if ((int32_t) (now - task->release_ms) >= 0) {
+			late = (now - task->release_ms) / task->stats.period_ms + 1;
+			task->stats.late += late;
+			task->release_ms += late * task->stats.period_ms;
+		}
+		scheduler_execute(task);
+		return true;
+	}
+
+	// Each background task runs once per millisecond, the core sleeps for the rest of it
+	if (now != scheduler_background_ms) {
+		scheduler_background_ms = now;
+		scheduler_background_runs = 0;
+	}
+	if (scheduler_background_runs >= scheduler_background_count) {
+		return false;
+	}
+
+	for (n = 0; n < scheduler_count; n++) {
+		task = &scheduler_tasks[(scheduler_next_background + n) % scheduler_count];
+		if (task->stats.period_ms == SCHEDULER_BACKGROUND) {
+			scheduler_next_background = (task - scheduler_tasks + 1) % scheduler_count;
+			scheduler_background_runs++;
+			scheduler_execute(task);
+			return true;
+		}
+	}
+	return false;
+}
+
+// Function to run the tasks forever
+void scheduler_run(void) {
+	while (1) {
+		if (!scheduler_run_once()) {
+			__WFI();
+		}
+	}
+}
+
+// Function to get the run time accounting of a task
+const scheduler_task_stats_t* scheduler_get_stats(uint8_t task) {
+	return (task < scheduler_count) ? &scheduler_tasks[task].stats : NULL;
+}
+
+// Function to clear the run time accounting
+void scheduler_clear_stats(void) {
+	uint8_t t;
+
+	for (t = 0; t < scheduler_count; t++) {
+		scheduler_tasks[t].stats.runs = 0;
+		scheduler_tasks[t].stats.max_cycles = 0;
+		scheduler_tasks[t].stats.total_cycles = 0;
+		scheduler_tasks[t].stats.late = 0;
+	}
+}
+
+// Function to print the run time accounting
+void scheduler_dump(void (*write)(char *text)) {
+	const scheduler_task_stats_t *stats;
+	char line[96];
+	uint8_t t;
+
+	write("TASKS\r\n");
+	for (t = 0; t < scheduler_count; t++) {
+		stats = &scheduler_tasks[t].stats;
+		snprintf(line, sizeof(line), "%-8s %5lu %u %8lu %7lu %7lu %5lu\r\n", stats->name,
+				(unsigned long) stats->period_ms, stats->priority, (unsigned long) stats->runs,
+				(unsigned long) (stats->runs ? cycles_to_us(stats->total_cycles / stats->runs) : 0),
+				(unsigned long) cycles_to_us(stats->max_cycles), (unsigned long) stats->late);
+		write(line);
+	}
+	write("END\r\n");
+}
@@ -26,233 +26,339 @@
 #include "beeper.h"
 #include "voice.h"
 #include "UART.h"
+#include "credentials.h"
+#include "credential_store.h"
+#include "debug_log.h"
+#include "whitelist.h"
+#include "whitelist_size.h"
+#include "bloom_filter.h"
+#include "journal.h"
+#include "delay.h"
+#include "pin.h"
 
 //Defining fields for checking Valid and Invalid cards
-#define VALID_CARDS	2
 #define TOTAL_CARDS	4
-#define UID_LENGTH	10
-#define PASSWORD_LENGTH	5
+#define UID_LENGTH	(2 * MFRC522_UID_MAX_SIZE + 1)
 #define MAX_INPUT_LENGTH	20
-uint8_t rfid_id[TOTAL_CARDS] = { 0 };
-
-//Defining char arrays for card UIDs
-char *myTags[VALID_CARDS] = { };
-
-char uid_1[UID_LENGTH] = "e39a9fb";
-char uid_2[UID_LENGTH] = "23a2a2c5";
-char uid_3[UID_LENGTH] = { 0 };
-char uid_4[UID_LENGTH] = { 0 };
+//Time allowed to finish a password, and time a decision stays on the OLED
+#define PASSWORD_TIMEOUT_MS	15000
+#define RESULT_HOLD_MS	1500
+//Card filter size in bits (a power of two) and hashes, 10 bits per card with 7 hashes rejects 99.2% of unknown cards.
+//The filter has room for every card that can be enrolled and every card of the whitelist.
+#define CARD_FILTER_CARDS	(CREDENTIALS_MAX_CARDS + WHITELIST_CARDS)
+#define CARD_FILTER_BITS_PER_CARD	10
+#ifndef CARD_FILTER_BITS
+#define CARD_FILTER_BITS	BLOOM_FILTER_SIZE_FOR(CARD_FILTER_CARDS * CARD_FILTER_BITS_PER_CARD)
+#endif
+#ifndef CARD_FILTER_HASHES
+#define CARD_FILTER_HASHES	7
+#endif
+RC522_uid_t rfid_cards[MFRC522_INVENTORY_MAX] = { 0 };
+RC522_event_t rfid_events[MFRC522_EVENTS_MAX];
 
 bool add_tag = true;
-char admin_password[PASSWORD_LENGTH] = "1234";
-char security_password[PASSWORD_LENGTH] = "5678";
+//Salted SHA-256 of the passwords, made with Simulator/pin_gen
+static const pin_hash_t admin_password = {
+		{ 0xAC, 0x01, 0xAF, 0x58, 0x41, 0x55, 0xBB, 0x31, 0x5C, 0x24, 0xD2, 0xAC, 0xC6, 0x7D, 0x49, 0xCC },
+		{ 0x51, 0x6B, 0x05, 0xD7, 0xDF, 0x32, 0x57, 0x28, 0xA3, 0xB6, 0xEE, 0x55, 0x73, 0x2C, 0x70, 0xB0,
+		  0x34, 0xA5, 0x4A, 0x80, 0x6E, 0x6B, 0x70, 0x8F, 0x6C, 0x27, 0x00, 0x91, 0x39, 0x75, 0x47, 0x33 } };
+static const pin_hash_t security_password = {
+		{ 0x5D, 0x43, 0x25, 0xB0, 0x4F, 0x00, 0xF7, 0x12, 0x1C, 0x5F, 0x23, 0x06, 0xA2, 0x7D, 0x43, 0xD4 },
+		{ 0x7C, 0xCF, 0xC6, 0x19, 0x07, 0x30, 0x2A, 0x50, 0x74, 0xAB, 0x12, 0xDB, 0x57, 0x6A, 0x94, 0xB8,
+		  0x17, 0x24, 0x2F, 0x7F, 0x57, 0x30, 0x9F, 0xB9, 0xCF, 0x90, 0x59, 0x42, 0x2A, 0x8C, 0xCD, 0xB9 } };
 char received_string[MAX_INPUT_LENGTH];
-int i = 0;
-unsigned char tagindex = 0;
+static uint8_t input_length = 0;
+static uint8_t card_count = 0;
+static access_state_t access_state = ACCESS_IDLE;
+static uint32_t access_entered_ms = 0;
 
-char buffer[MAX_INPUT_LENGTH];
+char buffer[UID_LENGTH];
 
-void check_access(void) {
-	//Checking if a card is tapped against the RFID reader
-	if (RC522_check_card(rfid_id)) {
-	//Extracting the UID of the tapped card.
-		sprintf(buffer, "%x%x%x%x", rfid_id[0], rfid_id[1], rfid_id[2],
-				rfid_id[3]);
-#ifdef DEBUG
-		USART2_string_transmit("\r\n");
-#endif
-	//Validating the obtained UID of the tapped card against the valid cards saved in the system
-		if ((strcmp(buffer, uid_1) == 0) || (strcmp(buffer, uid_2) == 0)
-				|| (strcmp(buffer, uid_3) == 0)
-				|| (strcmp(buffer, uid_4) == 0)) {
-#ifdef DEBUG
-			USART2_string_transmit("Access Granted \r\n");
-#endif
-		//Displaying Access Granted on the OLED.
-			SSD1106_gotoXY(0, 0);
-			SSD1106_puts("  Access Granted  ", &Font_7x10, 1);
-			SSD1106_gotoXY(0, 10);
-			SSD1106_clear_line();
-			SSD1106_gotoXY(0, 20);
+static uint32_t card_filter_bits[CARD_FILTER_BITS / 32];
+static bloom_filter_t card_filter;
+
+//Formatting a card UID as a hex string, two digits per byte
+static void format_uid(const RC522_uid_t *uid, char *str) {
+	str[0] = '\0';
+	for (unsigned char j = 0; j < uid->size; j++) {
+		sprintf(&str[2 * j], "%02x", uid->uid[j]);
+	}
+}
+
+//Adding a card to the card filter
+static void card_filter_add(const uint8_t *uid, uint8_t size) {
+	bloom_filter_add(&card_filter, uid, size);
+}
+
+//Rebuilding the card filter from the whitelist and the enrolled cards, after any change to them
+static void card_filter_rebuild(void) {
+	bloom_filter_clear(&card_filter);
+	for (uint32_t n = 0; n < whitelist.count; n++) {
+		card_filter_add(whitelist.uids[n].uid, whitelist.uids[n].size);
+	}
+	credentials_for_each(card_filter_add);
+	//Fewer bits per card let more unknown cards through to the table search
+	if (card_filter.cards * CARD_FILTER_BITS_PER_CARD > CARD_FILTER_BITS) {
+		debug_log(DEBUG_LOG_CARD_FILTER_LOAD, card_filter.cards, CARD_FILTER_BITS / card_filter.cards);
+	}
+}
+
+//Loading the cards enrolled by the admin from flash, the site cards are in the whitelist
+void security_system_init(void) {
+	if (!credential_store_init()) {
+		debug_log(DEBUG_LOG_CREDENTIAL_STORE_MOUNT, credential_store_get_stats()->cards, 0);
+	}
+	if (!journal_init()) {
+		debug_log(DEBUG_LOG_JOURNAL_MOUNT, journal_get_stats()->events, 0);
+	}
+	bloom_filter_init(&card_filter, card_filter_bits, CARD_FILTER_BITS, CARD_FILTER_HASHES);
+	card_filter_rebuild();
+}
+
+//Showing three lines on the OLED, NULL clears a line. The OLED task sends the buffer to the display.
+static void access_display(char *line0, char *line1, char *line2) {
+	char *lines[3] = { line0, line1, line2 };
+
+	for (uint8_t l = 0; l < 3; l++) {
+		SSD1106_gotoXY(0, 10 * l);
+		if (lines[l]) {
+			SSD1106_puts(lines[l], &Font_7x10, 1);
+		} else {
 			SSD1106_clear_line();
-			SSD1106_update_screen(); //display
-			beeper_enable();
-			delay(50);
 		}
+	}
+}
 
-		else {
-#ifdef DEBUG
-			USART2_string_transmit("Card does not exist.\r\n");
-#endif
-		//Displaying Card doesnot exist on the LED
-			SSD1106_gotoXY(0, 0);
-			SSD1106_puts("Card doesn't exist", &Font_7x10, 1);
+//Moving to a state and starting its timer
+static void access_enter(access_state_t state) {
+	access_state = state;
+	access_entered_ms = millis();
+}
+
+//Starting the entry of a password, the digits typed before the prompt are not kept
+static void access_prompt(access_state_t state, char *line0, char *line1, char *line2) {
+	input_length = 0;
+	received_string[0] = '\0';
+	access_display(line0, line1, line2);
+	access_enter(state);
+}
+
+//Showing a decision, it stays on the OLED for RESULT_HOLD_MS
+static void access_result(bool granted, char *line0, char *line1, char *line2) {
+	access_display(line0, line1, line2);
+	if (granted) {
+		beeper_start(50);
+	} else {
 		//Playing Access Denied message on the Playback module
-			voice_check();
+		voice_start();
+	}
+	access_enter(ACCESS_RESULT);
+}
+
+//Reading the cards tapped since the last poll, a card held on the reader is reported once
+static uint8_t access_read_cards(void) {
+	uint8_t count = 0;
+	uint8_t events = RC522_poll_events(rfid_events, MFRC522_EVENTS_MAX);
+
+	for (unsigned char e = 0; e < events; e++) {
+		if ((rfid_events[e].type == RC522_EVENT_PRESENTED) && (count < MFRC522_INVENTORY_MAX)) {
+			rfid_cards[count++] = rfid_events[e].uid;
+		}
 #ifdef DEBUG
-			USART2_string_transmit(
-					"Please enter 4 digit admin password for security pass\r\n");
-#endif	//Taking security password input from the user using the Keypad and displaying on OLED
-			SSD1106_gotoXY(0, 10);
-			SSD1106_puts("   Please enter   ", &Font_7x10, 1);
-			SSD1106_gotoXY(0, 20);
-			SSD1106_puts("security password:", &Font_7x10, 1);
-			SSD1106_update_screen(); //display
-			strcpy(received_string, check_key());
-
-		//Checking if the correct Security password has been entered and displaying "Access Granted" if it's correct. 
-			if (strcmp(security_password, received_string) == 0) {
-				SSD1106_gotoXY(0, 0);
-				SSD1106_puts("  Access Granted  ", &Font_7x10, 1);
-				SSD1106_gotoXY(0, 10);
-				SSD1106_clear_line();
-				SSD1106_gotoXY(0, 20);
-				SSD1106_clear_line();
-				SSD1106_update_screen(); //display
-		//Buzzer ON if access is granted
-				beeper_enable();
-
-		//If the incorrect security password has been entered, get input displau "Security password wrong" on OLED
-			} else if (strcmp(security_password, received_string) != 0) {
-				SSD1106_gotoXY(0, 0);
-				SSD1106_puts("Security password ", &Font_7x10, 1);
-				SSD1106_gotoXY(0, 10);
-				SSD1106_puts("       wrong      ", &Font_7x10, 1);
-				SSD1106_gotoXY(0, 20);
-				SSD1106_clear_line();
-				SSD1106_update_screen(); //display
-				//Playing Access Denied message on the Playback module
-				voice_check();
-				//Checking if Valid cards in database is equal to total cards 
-				for (unsigned char j = 0; j < VALID_CARDS; j++) {
-					if (strcmp(buffer, myTags[j]) == 0) {
-						add_tag = false;
-						break; //// If valid cards = total cards , we cannot add more cards to the system
-					}
-					add_tag = true; // If valid cards > total cards , we can add more cards to the system
-				}
-
-			//If a card is valid and valid cards < total cards, accept user input for Admin password to add a card from the Keypad
-				if ((i < VALID_CARDS) && (add_tag == true)) {
+		if (rfid_events[e].type == RC522_EVENT_REMOVED) {
+			USART2_string_transmit("Card removed\r\n");
+		}
+#endif
+	}
+	return count;
+}
+
+//Checking the tapped cards, any valid card in a stack grants access
+static void access_check_cards(void) {
+	journal_reason_t reason = JOURNAL_REASON_WHITELIST;
+	unsigned char card;
+
+	for (card = 0; card < card_count; card++) {
+		//Most unknown cards stop at the filter without searching the card tables
+		if (!bloom_filter_may_contain(&card_filter, rfid_cards[card].uid, rfid_cards[card].size)) {
+			continue;
+		}
+		if (whitelist_find(&whitelist, rfid_cards[card].uid, rfid_cards[card].size)) {
+			reason = JOURNAL_REASON_WHITELIST;
+			break;
+		}
+		if (credentials_find(rfid_cards[card].uid, rfid_cards[card].size)) {
+			reason = JOURNAL_REASON_ENROLLED_CARD;
+			break;
+		}
+	}
+	//No valid card, the first one goes through the security password flow
+	format_uid(&rfid_cards[card < card_count ? card : 0], buffer);
 #ifdef DEBUG
+	USART2_string_transmit(buffer);
+	USART2_string_transmit("\r\n");
+#endif
 
-			//Displaying "Please enter admin password" on OLED
-					USART2_string_transmit(
-							"Please enter 4 digit admin password for adding a card\r\n");
+	if (card < card_count) {
+		//Recording the decision, the journal writes it to flash after the door is handled
+		journal_log(JOURNAL_GRANTED, reason, &rfid_cards[card]);
+#ifdef DEBUG
+		USART2_string_transmit("Access Granted \r\n");
 #endif
-					SSD1106_gotoXY(0, 0);
-					SSD1106_puts("  Please enter    ", &Font_7x10, 1);
-					SSD1106_gotoXY(0, 10);
-					SSD1106_puts("  admin password  ", &Font_7x10, 1);
-					SSD1106_gotoXY(0, 20);
-					SSD1106_puts("  to add a card:  ", &Font_7x10, 1);
-					SSD1106_update_screen(); //display
-
-				//Validate admin password, and if correct, add the card as a valid card to the system
-					if (strcmp(admin_password, check_key()) == 0) {
-						myTags[i] = strdup(buffer);
-						if (i == 0) {
-							strcpy(uid_3, buffer);
-						}
-						if (i == 1) {
-							strcpy(uid_4, buffer);
-						}
+		access_result(true, "  Access Granted  ", NULL, NULL);
+		return;
+	}
+
 #ifdef DEBUG
+	USART2_string_transmit("Card does not exist.\r\n");
+	USART2_string_transmit("Please enter 4 digit admin password for security pass\r\n");
+#endif
+	//Playing Access Denied message and asking for the security password
+	voice_start();
+	access_prompt(ACCESS_PIN_ENTRY, "Card doesn't exist", "   Please enter   ", "security password:");
+}
 
-				//Display "Adding an access card" on OLED
-						USART2_string_transmit("Adding an access card\r\n");
+//Checking the security password of an unknown card
+static void access_check_security_password(void) {
+	bool match = pin_verify(&security_password, received_string);
+
+	//The entered digits are not kept once they have been checked
+	memset(received_string, 0, sizeof(received_string));
+	if (match) {
+		journal_log(JOURNAL_GRANTED, JOURNAL_REASON_SECURITY_PASSWORD, &rfid_cards[0]);
+		access_result(true, "  Access Granted  ", NULL, NULL);
+		return;
+	}
+
+	journal_log(JOURNAL_DENIED, JOURNAL_REASON_WRONG_PASSWORD, &rfid_cards[0]);
+	//Checking the enrolled card store has room for one more card
+	add_tag = (credentials_get_stats()->count < credentials_get_stats()->capacity);
+	if (!add_tag) {
+		access_result(false, "Security password ", "       wrong      ", NULL);
+		return;
+	}
+
+#ifdef DEBUG
+	USART2_string_transmit("Please enter 4 digit admin password for adding a card\r\n");
 #endif
-						SSD1106_gotoXY(0, 0);
-						SSD1106_puts("    Card added    ", &Font_7x10, 1);
-						SSD1106_gotoXY(0, 10);
-						SSD1106_clear_line();
-						SSD1106_gotoXY(0, 20);
-						SSD1106_clear_line();
-						SSD1106_update_screen(); //display
+	//If the store has room, accept the admin password to add the card
+	voice_start();
+	access_prompt(ACCESS_ADMIN_ENROLL, "  Please enter    ", "  admin password  ", "  to add a card:  ");
+}
+
+//Checking the admin password, and if correct, adding the card as a valid card to the system
+static void access_check_admin_password(void) {
+	bool match = pin_verify(&admin_password, received_string);
+	bool card_added;
+
+	memset(received_string, 0, sizeof(received_string));
+	if (!match) {
+		journal_log(JOURNAL_DENIED, JOURNAL_REASON_WRONG_ADMIN_PASSWORD, &rfid_cards[0]);
 #ifdef DEBUG
-						USART2_string_transmit("\r\n");
+		USART2_string_transmit("Admin password wrong.Access Denied\r\n");
 #endif
-						i++;
-				//Checking the valid cards database for a match for the tapped card
-						for (unsigned char j = 0; j < VALID_CARDS; j++) {
-							if (strcmp(buffer, myTags[j]) == 0) {
-								tagindex = j;
-								break;
-							}
-						}
-
-			// Granting access to Valid cards by checking UIDs from system database. 
-			//Giving access to the Valid card by displaying "Access granted" and beeping buzzer
-						if (tagindex < VALID_CARDS) {
+		access_result(false, "  Admin password  ", "      wrong.      ", "  Access Denied   ");
+		return;
+	}
+
+	//The card is written to flash so it survives a reset
+	card_added = credential_store_add(rfid_cards[0].uid, rfid_cards[0].size);
+	card_filter_rebuild();
+	journal_log(card_added ? JOURNAL_ENROLLED : JOURNAL_DENIED,
+			card_added ? JOURNAL_REASON_ADMIN_PASSWORD : JOURNAL_REASON_STORE_ERROR, &rfid_cards[0]);
+	if (card_added) {
 #ifdef DEBUG
-							USART2_string_transmit("Access granted\r\n");
+		USART2_string_transmit("Adding an access card\r\n");
+		USART2_string_transmit("Access granted\r\n");
 #endif
-							SSD1106_gotoXY(0, 0);
-							SSD1106_puts("  Access Granted  ", &Font_7x10, 1);
-							SSD1106_gotoXY(0, 10);
-							SSD1106_clear_line();
-							SSD1106_gotoXY(0, 20);
-							SSD1106_clear_line();
-							SSD1106_update_screen(); //display
-							beeper_enable();
-						} else {
+		access_result(true, "  Access Granted  ", "    Card added    ", NULL);
+	} else {
 #ifdef DEBUG
-
-			//Rejecting access to the Invalid card by displaying "Access Rejected" and playing audio on playback module
-							USART2_string_transmit("Access rejected\r\n");
-							USART2_string_transmit("Please try again\r\n");
+		USART2_string_transmit("Access rejected\r\n");
+		USART2_string_transmit("Please try again\r\n");
 #endif
-							SSD1106_gotoXY(0, 0);
-							SSD1106_puts("  Access Denied   ", &Font_7x10, 1);
-							SSD1106_gotoXY(0, 10);
-							SSD1106_puts("     Try again.   ", &Font_7x10, 1);
-							SSD1106_gotoXY(0, 20);
-							SSD1106_clear_line();
-							SSD1106_update_screen(); //display
-							voice_check();
-						}
-
-				//If Admin password entered is wrong, display "Access Denied" on OLED and ask user to start process again
-
-					} else {
+		access_result(false, "  Access Denied   ", "     Try again.   ", NULL);
+	}
+}
+
+//Taking one key of a password, '#' ends the password
+static void access_key(char key) {
+	if (key == '#') {
+		if (access_state == ACCESS_PIN_ENTRY) {
+			access_check_security_password();
+		} else {
+			access_check_admin_password();
+		}
+	} else if ((key >= '0') && (key <= '9')) {
+		if (input_length < MAX_INPUT_LENGTH - 1) {
+			received_string[input_length++] = key;
+			received_string[input_length] = '\0';
+		}
+	} else if (key != '\0') {
 #ifdef DEBUG
-						USART2_string_transmit(
-								"Admin password wrong.Access Denied\r\n");
+		USART2_string_transmit("Invalid input. Please enter digits only.\r\n");
 #endif
-						SSD1106_gotoXY(0, 0);
-						SSD1106_puts("  Admin password  ", &Font_7x10, 1);
-						SSD1106_gotoXY(0, 10);
-						SSD1106_puts("      wrong.      ", &Font_7x10, 1);
-						SSD1106_gotoXY(0, 20);
-						SSD1106_puts("  Access Denied   ", &Font_7x10, 1);
-						SSD1106_update_screen(); //display
-						voice_check();
+	}
+}
 
-					}
+//Polling the RFID reader, a new tap restarts the flow with that card, even in the middle of a password
+void access_poll_cards(void) {
+	uint8_t count;
 
-				}
+	if (access_state == ACCESS_RESULT) {
+		return;
+	}
+	count = access_read_cards();
+	if (count) {
+		card_count = count;
+		access_enter(ACCESS_CARD_READ);
+		access_check_cards();
+	}
+}
 
-				delay(100);
+//Scanning the keypad while a password is expected
+void access_poll_keypad(void) {
+	if ((access_state == ACCESS_PIN_ENTRY) || (access_state == ACCESS_ADMIN_ENROLL)) {
+		access_key(keypad_scan());
+	}
+}
 
-		// If flow is disrupted at any point, system goes into this loop and states "Acces Denied", "Try again."
-			} else {
+//Handling the timeouts of the access flow
+void access_update_timers(void) {
+	switch (access_state) {
+	case ACCESS_PIN_ENTRY:
+	case ACCESS_ADMIN_ENROLL:
+		//A password that is not finished in time denies access
+		if (millis() - access_entered_ms >= PASSWORD_TIMEOUT_MS) {
+			journal_log(JOURNAL_DENIED, JOURNAL_REASON_PASSWORD_TIMEOUT, &rfid_cards[0]);
 #ifdef DEBUG
-				USART2_string_transmit("Admin password wrong.Access Denied\r\n");
-				USART2_string_transmit("Please try again\r\n");
+			USART2_string_transmit("Password timed out.Access Denied\r\n");
 #endif
-				SSD1106_gotoXY(0, 0);
-				SSD1106_puts("  Admin password  ", &Font_7x10, 1);
-				SSD1106_gotoXY(0, 10);
-				SSD1106_puts("      wrong.      ", &Font_7x10, 1);
-				SSD1106_gotoXY(0, 20);
-				SSD1106_puts("  Access Denied   ", &Font_7x10, 1);
-				SSD1106_gotoXY(0, 30);
-				SSD1106_puts("    Try again.    ", &Font_7x10, 1);
-				SSD1106_update_screen(); //display
-				voice_check();
-			}
+			access_result(false, "  Access Denied   ", "    Timed out.    ", NULL);
+		}
+		break;
+
+	case ACCESS_RESULT:
+		//Going back to the default message once the decision has been shown
+		if (millis() - access_entered_ms >= RESULT_HOLD_MS) {
+			access_display("Please tap card   ", NULL, NULL);
+			access_enter(ACCESS_IDLE);
 		}
-		delay(100);
+		break;
+
+	default:
+		break;
 	}
 }
 
+void check_access(void) {
+	access_poll_cards();
+	access_poll_keypad();
+	access_update_timers();
+	SSD1106_flush();
+}
+
+//Getting the state of the access flow
+access_state_t access_get_state(void) {
+	return access_state;
+}
@@ -0,0 +1,169 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   sha256.c
+* @brief  A file defining the compact SHA-256.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 17, 2023
+* @revision 1.0
+*
+*/
+
+#include <string.h>
+#include "sha256.h"
+
+// Rotate right, compiled to one ROR instruction
+#define ROR(x, n)			(((x) >> (n)) | ((x) << (32 - (n))))
+#define CH(x, y, z)			(((x) & ((y) ^ (z))) ^ (z))
+#define MAJ(x, y, z)		(((x) & (y)) | ((z) & ((x) | (y))))
+#define SIGMA0(x)			(ROR(x, 2) ^ ROR(x, 13) ^ ROR(x, 22))
+#define SIGMA1(x)			(ROR(x, 6) ^ ROR(x, 11) ^ ROR(x, 25))
+#define GAMMA0(x)			(ROR(x, 7) ^ ROR(x, 18) ^ ((x) >> 3))
+#define GAMMA1(x)			(ROR(x, 17) ^ ROR(x, 19) ^ ((x) >> 10))
+
+// Schedule word i (16 and up) computed in place in the 16 word ring
+#define SCHEDULE(w, i)		(w[(i) & 15] += GAMMA1(w[((i) - 2) & 15]) + w[((i) - 7) & 15] \
+		+ GAMMA0(w[((i) - 15) & 15]))
+
+// One round, the callers rotate the names of the working variables instead of moving them
+#define ROUND(a, b, c, d, e, f, g, h, k, w) do { \
+		uint32_t t = (h) + SIGMA1(e) + CH(e, f, g) + (k) + (w); \
+		(d) += t; \
+		(h) = t + SIGMA0(a) + MAJ(a, b, c); \
+	} while (0)
+
+static const uint32_t sha256_k[64] = {
+	0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+	0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+	0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+	0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+	0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+	0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+	0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+	0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+};
+
+// Function to read a big endian word
+static uint32_t sha256_load(const uint8_t *p) {
+	return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+// Function to write a big endian word
+static void sha256_store(uint8_t *p, uint32_t x) {
+	p[0] = x >> 24;
+	p[1] = x >> 16;
+	p[2] = x >> 8;
+	p[3] = x;
+}
+
+// Function to hash one 64 byte block into the state, eight rounds per pass of the loop
+static void sha256_compress(uint32_t state[8], const uint8_t *block) {
+	uint32_t w[16];
+	uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+	uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+	uint8_t i;
+
+	for (i = 0; i < 16; i++) {
+		w[i] = sha256_load(&block[4 * i]);
+	}
+
+	for (i = 0; i < 64; i += 8) {
+		if (i >= 16) {
+			SCHEDULE(w, i + 0);
+			SCHEDULE(w, i + 1);
+			SCHEDULE(w, i + 2);
+			SCHEDULE(w, i + 3);
+			SCHEDULE(w, i + 4);
+			SCHEDULE(w, i + 5);
+			SCHEDULE(w, i + 6);
+			SCHEDULE(w, i + 7);
+		}
+		ROUND(a, b, c, d, e, f, g, h, sha256_k[i + 0], w[(i + 0) & 15]);
+		ROUND(h, a, b, c, d, e, f, g, sha256_k[i + 1], w[(i + 1) & 15]);
+		ROUND(g, h, a, b, c, d, e, f, sha256_k[i + 2], w[(i + 2) & 15]);
+		ROUND(f, g, h, a, b, c, d, e, sha256_k[i + 3], w[(i + 3) & 15]);
+		ROUND(e, f, g, h, a, b, c, d, sha256_k[i + 4], w[(i + 4) & 15]);
+		ROUND(d, e, f, g, h, a, b, c, sha256_k[i + 5], w[(i + 5) & 15]);
+		ROUND(c, d, e, f, g, h, a, b, sha256_k[i + 6], w[(i + 6) & 15]);
+		ROUND(b, c, d, e, f, g, h, a, sha256_k[i + 7], w[(i + 7) & 15]);
+	}
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+	state[5] += f;
+	state[6] += g;
+	state[7] += h;
+}
+
+// Function to start a hash
+void sha256_init(sha256_t *ctx) {
+	static const uint32_t initial[8] = { 0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C,
+			0x1F83D9AB, 0x5BE0CD19 };
+
+	memcpy(ctx->state, initial, sizeof(initial));
+	ctx->length = 0;
+}
+
+// Function to add bytes to a hash
+void sha256_update(sha256_t *ctx, const void *data, size_t length) {
+	const uint8_t *p = data;
+	size_t used = ctx->length % SHA256_BLOCK_SIZE;
+	size_t n;
+
+	ctx->length += length;
+	while (length) {
+		// Whole blocks are hashed straight from the caller's buffer
+		if ((used == 0) && (length >= SHA256_BLOCK_SIZE)) {
+			sha256_compress(ctx->state, p);
+			p += SHA256_BLOCK_SIZE;
+			length -= SHA256_BLOCK_SIZE;
+			continue;
+		}
+		n = SHA256_BLOCK_SIZE - used;
+		if (n > length) {
+			n = length;
+		}
+		memcpy(&ctx->block[used], p, n);
+		used += n;
+		p += n;
+		length -= n;
+		if (used == SHA256_BLOCK_SIZE) {
+			sha256_compress(ctx->state, ctx->block);
+			used = 0;
+		}
+	}
+}
+
+// Function to finish a hash: 0x80, zeros and the length in bits end the last block
+void sha256_final(sha256_t *ctx, uint8_t digest[SHA256_DIGEST_SIZE]) {
+	size_t used = ctx->length % SHA256_BLOCK_SIZE;
+	uint64_t bits = ctx->length * 8;
+	uint8_t i;
+
+	ctx->block[used++] = 0x80;
+	if (used > SHA256_BLOCK_SIZE - 8) {
+		memset(&ctx->block[used], 0, SHA256_BLOCK_SIZE - used);
+		sha256_compress(ctx->state, ctx->block);
+		used = 0;
+	}
+	memset(&ctx->block[used], 0, SHA256_BLOCK_SIZE - 8 - used);
+	sha256_store(&ctx->block[SHA256_BLOCK_SIZE - 8], bits >> 32);
+	sha256_store(&ctx->block[SHA256_BLOCK_SIZE - 4], bits);
+	sha256_compress(ctx->state, ctx->block);
+
+	for (i = 0; i < 8; i++) {
+		sha256_store(&digest[4 * i], ctx->state[i]);
+	}
+}
@@ -22,8 +22,16 @@
 #include "spi.h"
 #include "stm32f4xx.h"
 #include "delay.h"
+#include "debug_log.h"
 
 #define AF5 0x05
+#define SPI1_DMA_CHANNEL	3	// SPI1_RX is DMA2 stream 2 and SPI1_TX is DMA2 stream 3, both on channel 3
+
+static volatile bool spi_dma_busy = false;
+static spi_callback_t spi_dma_callback = NULL;
+static uint8_t spi_dma_dummy_tx = 0;
+static uint8_t spi_dma_dummy_rx;
+static volatile uint32_t spi_transaction_count = 0;
 
 // Function to initialize the SPI communication
 void spi_init(void) {
@@ -45,6 +53,47 @@ void spi_init(void) {
 
 	// Set SPI1 as Master, Set Baud Rate, Enable s/w Slave Management, Enable SPI1
 	SPI1->CR1 = SPI_CR1_SSM | SPI_CR1_MSTR | SPI_CR1_BR_2 | SPI_CR1_SSI | SPI_CR1_SPE;
+
+	// Enable clock for DMA2, the SPI1 RX stream interrupt signals completion and the TX stream one errors
+	RCC->AHB1ENR |= RCC_AHB1ENR_DMA2EN;
+	NVIC_EnableIRQ(DMA2_Stream2_IRQn);
+	NVIC_EnableIRQ(DMA2_Stream3_IRQn);
+}
+
+// Function to set the SPI1 baud-rate divider, the peripheral is disabled while it changes
+int8_t spi_set_clock_divider(uint16_t divider) {
+	uint32_t br = 0;
+
+	// BR[2:0] selects fPCLK / 2^(BR + 1)
+	while ((br < 8) && ((2U << br) != divider)) {
+		br++;
+	}
+	if (br == 8) {
+		return -1;
+	}
+
+	while ((SPI1->SR) & SPI_SR_BSY) {
+	}
+
+	SPI1->CR1 &= ~SPI_CR1_SPE;
+	SPI1->CR1 = (SPI1->CR1 & ~SPI_CR1_BR) | (br << SPI_CR1_BR_Pos);
+	SPI1->CR1 |= SPI_CR1_SPE;
+
+	return 0;
+}
+
+// Function to get the SPI1 baud-rate divider
+uint16_t spi_get_clock_divider(void) {
+	return 2U << ((SPI1->CR1 & SPI_CR1_BR) >> SPI_CR1_BR_Pos);
+}
+
+// Function to get the SPI1 clock frequency
+uint32_t spi_get_clock_hz(void) {
+	// SPI1 sits on APB2
+	uint32_t pclk2 = SystemCoreClock
+			>> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE2) >> RCC_CFGR_PPRE2_Pos];
+
+	return pclk2 / spi_get_clock_divider();
 }
 
 // Function to transmit data over SPI
@@ -52,6 +101,8 @@ int8_t spi_transmit(uint8_t *data, uint32_t size) {
 	uint8_t i = 0;
 	uint32_t start = millis();
 
+	spi_transaction_count++;
+
 	// Used to check the value in the data register before transmission & clear it
 	if (SPI1->DR) {}
 
@@ -61,7 +112,7 @@ int8_t spi_transmit(uint8_t *data, uint32_t size) {
 	while (i < size) {
 		while (!((SPI1->SR) & SPI_SR_TXE)) {
 			if (millis() - start > 1000) { // Wait for transmit buffer to be empty
-				printf("TXE timed out\r\n");
+				debug_log(DEBUG_LOG_SPI_TXE_TIMEOUT, i, size);
 				return -1;
 			}
 		}
@@ -70,7 +121,7 @@ int8_t spi_transmit(uint8_t *data, uint32_t size) {
 
 		while (!(SPI1->SR & SPI_SR_BSY)) {
 			if (millis() - start > 1000) {
-				printf("BSY timed out\r\n");
+				debug_log(DEBUG_LOG_SPI_BSY_TIMEOUT, i, size);
 				return -1;
 			}
 		}
@@ -81,7 +132,7 @@ int8_t spi_transmit(uint8_t *data, uint32_t size) {
 	// Wait for Transmit buffer to be empty
 	while (!((SPI1->SR) & SPI_SR_TXE)) {
 		if (millis() - start > 1000) {
-			printf("TXE2 timed out\r\n");
+			debug_log(DEBUG_LOG_SPI_TXE_TIMEOUT, size, size);
 			return -1;
 		}
 	}
@@ -89,7 +140,7 @@ int8_t spi_transmit(uint8_t *data, uint32_t size) {
 	// Wait for transmit
 	while ((SPI1->SR) & SPI_SR_BSY) {
 		if (millis() - start > 1000) {
-			printf("BSY2 timed out\r\n");
+			debug_log(DEBUG_LOG_SPI_BSY_TIMEOUT, size, size);
 			return -1;
 		}
 	}
@@ -105,6 +156,8 @@ int8_t spi_transmit(uint8_t *data, uint32_t size) {
 
 // Function to receive data over SPI
 int8_t spi_receive(uint8_t *data, uint32_t size) {
+	spi_transaction_count++;
+
 	while (size) {
 		uint32_t start = millis();
 		SPI1->DR = 0;
@@ -121,3 +174,147 @@ int8_t spi_receive(uint8_t *data, uint32_t size) {
 
 	return 0;
 }
+
+// Function to exchange data over SPI, capturing one received byte per transmitted byte
+int8_t spi_transfer(const uint8_t *tx, uint8_t *rx, uint32_t size) {
+	uint32_t start = millis();
+	uint32_t i;
+	uint8_t data;
+
+	spi_transaction_count++;
+
+	// Used to check the value in the data register before transfer & clear it
+	if (SPI1->DR) {}
+
+	for (i = 0; i < size; i++) {
+		while (!((SPI1->SR) & SPI_SR_TXE)) {
+			if (millis() - start > 1000) { // Wait for transmit buffer to be empty
+				debug_log(DEBUG_LOG_SPI_TXE_TIMEOUT, i, size);
+				return -1;
+			}
+		}
+
+		SPI1->DR = tx ? tx[i] : 0;
+
+		while (!((SPI1->SR) & SPI_SR_RXNE)) {
+			if (millis() - start > 1000) { // Wait for the byte clocked in by the transmission
+				debug_log(DEBUG_LOG_SPI_RXNE_TIMEOUT, i, size);
+				return -1;
+			}
+		}
+
+		data = SPI1->DR;
+		if (rx) {
+			rx[i] = data;
+		}
+	}
+
+	// Wait for the bus to go idle before the caller releases chip-select
+	while ((SPI1->SR) & SPI_SR_BSY) {
+		if (millis() - start > 1000) {
+			debug_log(DEBUG_LOG_SPI_BSY_TIMEOUT, size, size);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+// Function to start a DMA driven full-duplex transfer over SPI
+int8_t spi_transfer_async(const uint8_t *tx, uint8_t *rx, uint32_t size,
+		spi_callback_t callback) {
+	if (spi_dma_busy || (size == 0) || (size > 0xFFFF)) {
+		return -1;
+	}
+
+	spi_dma_busy = true;
+	spi_transaction_count++;
+	spi_dma_callback = callback;
+
+	// Make sure both streams are stopped before reprogramming them
+	DMA2_Stream2->CR &= ~DMA_SxCR_EN;
+	DMA2_Stream3->CR &= ~DMA_SxCR_EN;
+	while ((DMA2_Stream2->CR & DMA_SxCR_EN) || (DMA2_Stream3->CR & DMA_SxCR_EN)) {
+	}
+
+	// Clear all the stale event flags of streams 2 and 3
+	DMA2->LIFCR = DMA_LIFCR_CTCIF2 | DMA_LIFCR_CHTIF2 | DMA_LIFCR_CTEIF2
+			| DMA_LIFCR_CDMEIF2 | DMA_LIFCR_CFEIF2 | DMA_LIFCR_CTCIF3
+			| DMA_LIFCR_CHTIF3 | DMA_LIFCR_CTEIF3 | DMA_LIFCR_CDMEIF3
+			| DMA_LIFCR_CFEIF3;
+
+	// RX stream: peripheral to memory, completion interrupt marks the end of the transfer
+	DMA2_Stream2->PAR = (uint32_t) &SPI1->DR;
+	DMA2_Stream2->M0AR = rx ? (uint32_t) rx : (uint32_t) &spi_dma_dummy_rx;
+	DMA2_Stream2->NDTR = size;
+	DMA2_Stream2->CR = (SPI1_DMA_CHANNEL << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_PL_1
+			| (rx ? DMA_SxCR_MINC : 0) | DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+
+	// TX stream: memory to peripheral, clocks out dummy bytes when there is nothing to send
+	// An error stops the RX stream from ever completing, so the TX stream reports it on its own
+	DMA2_Stream3->PAR = (uint32_t) &SPI1->DR;
+	DMA2_Stream3->M0AR = tx ? (uint32_t) tx : (uint32_t) &spi_dma_dummy_tx;
+	DMA2_Stream3->NDTR = size;
+	DMA2_Stream3->CR = (SPI1_DMA_CHANNEL << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_PL_1
+			| (tx ? DMA_SxCR_MINC : 0) | DMA_SxCR_DIR_0 | DMA_SxCR_TEIE;
+
+	// Used to check the value in the data register before transfer & clear it
+	if (SPI1->DR) {}
+
+	// Enable the RX stream first so no received byte is missed, then start transmitting
+	DMA2_Stream2->CR |= DMA_SxCR_EN;
+	DMA2_Stream3->CR |= DMA_SxCR_EN;
+	SPI1->CR2 |= SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN;
+
+	return 0;
+}
+
+// Function to get the number of SPI transactions
+uint32_t spi_get_transaction_count(void) {
+	return spi_transaction_count;
+}
+
+// Function to check if a DMA transfer is still running
+bool spi_transfer_busy(void) {
+	return spi_dma_busy;
+}
+
+// Function to stop both DMA streams, hand the SPI back to the polled functions and report the result
+static void spi_dma_finish(int8_t status) {
+	DMA2_Stream2->CR &= ~DMA_SxCR_EN;
+	DMA2_Stream3->CR &= ~DMA_SxCR_EN;
+	SPI1->CR2 &= ~(SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN);
+
+	// Only the first of the two streams to finish completes the transfer
+	if (!spi_dma_busy) {
+		return;
+	}
+	spi_dma_busy = false;
+	if (spi_dma_callback) {
+		spi_dma_callback(status);
+	}
+}
+
+// SPI1 RX DMA stream interrupt, the last received byte completes the transfer
+void DMA2_Stream2_IRQHandler(void) {
+	int8_t status = 0;
+
+	if (DMA2->LISR & DMA_LISR_TEIF2) {
+		status = -1;
+	} else if (!(DMA2->LISR & DMA_LISR_TCIF2)) {
+		return;
+	}
+
+	DMA2->LIFCR = DMA_LIFCR_CTCIF2 | DMA_LIFCR_CTEIF2;
+	spi_dma_finish(status);
+}
+
+// SPI1 TX DMA stream interrupt, only a transfer error is enabled
+void DMA2_Stream3_IRQHandler(void) {
+	if (!(DMA2->LISR & DMA_LISR_TEIF3)) {
+		return;
+	}
+
+	DMA2->LIFCR = DMA_LIFCR_CTEIF3;
+	spi_dma_finish(-1);
+}
@@ -22,6 +22,11 @@
 #include "delay.h"
 #include "UART.h"
 
+#define VOICE_PULSE_MS	10		// Trigger pulse length
+
+static uint32_t voice_start_ms;
+static uint8_t voice_on = 0;
+
 void voice_init() {
 	SET_BIT(RCC->AHB1ENR, RCC_AHB1ENR_GPIODEN);	// Enable the AHB clock all GPIO port B
 
@@ -30,7 +35,20 @@ void voice_init() {
 void voice_check() {
 	GPIOD->BSRR |= GPIO_BSRR_BS1;				// Turn ON the Voice Module
 
-	delay(10);
+	delay(VOICE_PULSE_MS);
 
 	GPIOD->BSRR |= GPIO_BSRR_BR1;				// Turn OFF the Voice Module
 }
+
+void voice_start() {
+	GPIOD->BSRR |= GPIO_BSRR_BS1;				// Turn ON the Voice Module, voice_update() turns it off
+	voice_start_ms = millis();
+	voice_on = 1;
+}
+
+void voice_update() {
+	if (voice_on && (millis() - voice_start_ms >= VOICE_PULSE_MS)) {
+		GPIOD->BSRR |= GPIO_BSRR_BR1;			// Turn OFF the Voice Module
+		voice_on = 0;
+	}
+}
@@ -0,0 +1,71 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   whitelist.c
+* @brief  A file defining the lookup of the generated site whitelist. The slot of a card is
+*         (f1 + d0 * f2 + d1) mod count, with f1 and f2 hashes of the UID and (d0, d1) the displacement
+*         the generator found for the bucket of the card.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 11, 2023
+* @revision 1.0
+*
+*/
+
+#include <string.h>
+#include "whitelist.h"
+
+// Function to mix the bits of a hash (MurmurHash3 finalizer)
+static uint32_t whitelist_mix(uint32_t h) {
+	h ^= h >> 16;
+	h *= 0x85EBCA6BU;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35U;
+	h ^= h >> 16;
+	return h;
+}
+
+// Function to hash a UID once (FNV-1a) and derive the bucket and slot hashes from it
+void whitelist_hash(uint32_t salt, const uint8_t *uid, uint8_t size, uint32_t hash[3]) {
+	uint32_t h = (2166136261U ^ salt ^ size) * 16777619U;
+	uint8_t i;
+
+	for (i = 0; i < size; i++) {
+		h = (h ^ uid[i]) * 16777619U;
+	}
+	hash[0] = whitelist_mix(h);
+	hash[1] = whitelist_mix(h ^ 0x9E3779B9U);
+	hash[2] = whitelist_mix(h ^ 0x7F4A7C15U);
+}
+
+// Function to get the slot of a hashed UID
+uint32_t whitelist_slot(const whitelist_table_t *table, const uint32_t hash[3]) {
+	uint32_t d = table->displace[hash[0] % table->buckets];
+	uint32_t f1 = hash[1] % table->count;
+	uint32_t f2 = hash[2] % table->count;
+
+	// d0 and f2 are below 2^16 so the product does not overflow
+	return (f1 + ((d >> 16) * f2) % table->count + (d & 0xFFFF)) % table->count;
+}
+
+// Function to look a card up
+bool whitelist_find(const whitelist_table_t *table, const uint8_t *uid, uint8_t size) {
+	const whitelist_uid_t *entry;
+	uint32_t hash[3];
+
+	if (table->count == 0) {
+		return false;
+	}
+
+	whitelist_hash(table->salt, uid, size, hash);
+	entry = &table->uids[whitelist_slot(table, hash)];
+	return (entry->size == size) && !memcmp(entry->uid, uid, size);
+}
@@ -0,0 +1,20 @@
+/*
+ * Generated by Simulator/whitelist_gen from whitelist.csv, do not edit.
+ * 5 cards, 2 buckets, salt 0.
+ */
+
+#include "whitelist.h"
+
+static const uint32_t whitelist_displace[2] = {
+	0x00000001, 0x00030000,
+};
+
+static const whitelist_uid_t whitelist_uids[5] = {
+	{ 4, { 0x23, 0xA2, 0xA2, 0xC5 } },
+	{ 4, { 0xE3, 0x09, 0xA9, 0xFB } },
+	{ 4, { 0xE3, 0x9A, 0x9F, 0x0B } },
+	{ 4, { 0x0E, 0x39, 0xA9, 0xFB } },
+	{ 4, { 0xE3, 0x9A, 0x09, 0xFB } },
+};
+
+const whitelist_table_t whitelist = { 5, 2, 0, whitelist_displace, whitelist_uids };
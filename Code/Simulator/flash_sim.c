@@ -0,0 +1,157 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   flash_sim.c
+* @brief  A file defining the flash.h APIs on a RAM copy of the 512 KB STM32F411 flash. Erases and programs
+*         take their typical time from the STM32F411 datasheet (250 ms per 16 KB sector, 550 ms per 64 KB sector,
+*         1 s per 128 KB sector, 16 us per word), or the maximum time (twice as long) after
+*         flash_sim_set_erase_max().
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 13, 2023
+* @revision 1.0
+*
+*/
+
+#include <string.h>
+#include <stdbool.h>
+#include "flash.h"
+#include "flash_sim.h"
+#include "mfrc522_sim.h"
+
+#define SIM_FLASH_SIZE			(512 * 1024)
+#define SIM_PROGRAM_US			16
+
+static const uint32_t flash_sector_kb[FLASH_SECTORS] = { 16, 16, 16, 16, 64, 128, 128, 128 };
+static const uint32_t flash_erase_ms[FLASH_SECTORS] = { 250, 250, 250, 250, 550, 1000, 1000, 1000 };	// Typical
+
+static uint32_t sim_flash[SIM_FLASH_SIZE / 4];
+static flash_sim_stats_t sim_stats;
+static int32_t sim_operations_left = -1;
+static bool sim_powered = true;
+static bool sim_erase_max = false;
+
+/* Outcome of a flash operation */
+typedef enum {
+	SIM_OP_DONE,		// Completed
+	SIM_OP_CUT,			// The power went off during the operation
+	SIM_OP_OFF			// The power was already off, nothing happens
+} sim_op_t;
+
+// Function to get the outcome of the next operation, it cuts the power when its turn comes
+static sim_op_t flash_sim_operation(void) {
+	if (!sim_powered) {
+		return SIM_OP_OFF;
+	}
+	if (sim_operations_left == 0) {
+		sim_powered = false;
+		return SIM_OP_CUT;
+	}
+	if (sim_operations_left > 0) {
+		sim_operations_left--;
+	}
+	return SIM_OP_DONE;
+}
+
+// Function to erase the whole flash
+void flash_sim_reset(void) {
+	memset(sim_flash, 0xFF, sizeof(sim_flash));
+	memset(&sim_stats, 0, sizeof(sim_stats));
+	sim_operations_left = -1;
+	sim_powered = true;
+}
+
+// Function to schedule a power cut
+void flash_sim_fail_after(int32_t operations) {
+	sim_operations_left = operations;
+}
+
+// Function to restore the power
+void flash_sim_power_on(void) {
+	sim_powered = true;
+	sim_operations_left = -1;
+}
+
+// Function to select the maximum erase time of the datasheet instead of the typical one
+void flash_sim_set_erase_max(bool max) {
+	sim_erase_max = max;
+}
+
+// Function to get the operation counters
+const flash_sim_stats_t* flash_sim_get_stats(void) {
+	return &sim_stats;
+}
+
+uintptr_t flash_sector_address(uint8_t sector) {
+	uint32_t offset = 0;
+	uint8_t s;
+
+	for (s = 0; (s < sector) && (s < FLASH_SECTORS); s++) {
+		offset += flash_sector_kb[s] * 1024;
+	}
+	return (uintptr_t) sim_flash + offset;
+}
+
+uint32_t flash_sector_size(uint8_t sector) {
+	return (sector < FLASH_SECTORS) ? flash_sector_kb[sector] * 1024 : 0;
+}
+
+int8_t flash_erase_sector(uint8_t sector) {
+	uint32_t *start;
+	uint32_t size;
+	sim_op_t op;
+
+	if (sector >= FLASH_SECTORS) {
+		return -1;
+	}
+
+	start = (uint32_t*) flash_sector_address(sector);
+	size = flash_sector_size(sector);
+	op = flash_sim_operation();
+	if (op != SIM_OP_DONE) {
+		// A cut erase leaves part of the sector erased and the rest as it was
+		if (op == SIM_OP_CUT) {
+			memset(start, 0xFF, size / 2);
+		}
+		return -1;
+	}
+
+	memset(start, 0xFF, size);
+	sim_stats.erases[sector]++;
+	sim_advance((uint64_t) flash_erase_ms[sector] * (sim_erase_max ? 2 : 1) * (SIM_CORE_HZ / 1000));
+	return 0;
+}
+
+int8_t flash_program_word(uintptr_t address, uint32_t data) {
+	uint32_t *word = (uint32_t*) address;
+	sim_op_t op;
+
+	if ((address & 0x03) || (word < sim_flash) || (word >= &sim_flash[SIM_FLASH_SIZE / 4])) {
+		return -1;
+	}
+
+	op = flash_sim_operation();
+	if (op != SIM_OP_DONE) {
+		// A cut program clears only some of the bits
+		if (op == SIM_OP_CUT) {
+			*word &= data | 0x0000FFFFU;
+		}
+		return -1;
+	}
+
+	if (*word != FLASH_ERASED_WORD) {
+		sim_stats.overwrites++;
+	}
+	*word &= data;
+	sim_stats.programs++;
+	sim_advance((uint64_t) SIM_PROGRAM_US * (SIM_CORE_HZ / 1000000));
+	return 0;
+}
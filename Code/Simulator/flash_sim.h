@@ -0,0 +1,81 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   flash_sim.h
+* @brief  A file declaring the controls of the host-side STM32F411 flash model behind flash.h. It can cut the
+*         power in the middle of an erase or program to check the recovery of the flash users.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 13, 2023
+* @revision 1.0
+*
+*/
+
+#ifndef __FLASH_SIM_H
+#define __FLASH_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Operation counters of the flash model */
+typedef struct {
+	uint32_t erases[8];		// Erases per sector
+	uint32_t programs;		// Words programmed
+	uint32_t overwrites;	// Programs of a word that was not erased
+} flash_sim_stats_t;
+
+/**
+ * @brief   A function to erase the whole flash and clear the counters.
+ *
+ * @param   None
+ *
+ * @return  None.
+ */
+void flash_sim_reset(void);
+
+/**
+ * @brief   A function to cut the power during a later flash operation. That operation is left half done and
+ *          every operation after it fails until flash_sim_power_on().
+ *
+ * @param   operations Erases and programs that still complete, -1 to never cut the power
+ *
+ * @return  None.
+ */
+void flash_sim_fail_after(int32_t operations);
+
+/**
+ * @brief   A function to restore the power after a cut, as done by a reset of the board.
+ *
+ * @param   None
+ *
+ * @return  None.
+ */
+void flash_sim_power_on(void);
+
+/**
+ * @brief   A function to choose the erase time of the model.
+ *
+ * @param   max True for the maximum erase time of the datasheet, false for the typical one
+ *
+ * @return  None.
+ */
+void flash_sim_set_erase_max(bool max);
+
+/**
+ * @brief   A function to get the operation counters.
+ *
+ * @param   None
+ *
+ * @return  Pointer to the counters.
+ */
+const flash_sim_stats_t* flash_sim_get_stats(void);
+
+#endif /* __FLASH_SIM_H */
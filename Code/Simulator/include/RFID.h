@@ -0,0 +1,2 @@
+/* Case-insensitive include of rfid.c, the target toolchain builds on a case-insensitive file system */
+#include "rfid.h"
@@ -0,0 +1,114 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   stm32f4xx.h
+* @brief  Host stand-in for the STM32F4 device header. It declares only the peripherals and bits
+*         used by rfid.c, backed by plain RAM structures so the driver compiles unchanged on Linux.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 5, 2023
+* @revision 1.0
+*
+*/
+
+#ifndef __STM32F4XX_SIM_H
+#define __STM32F4XX_SIM_H
+
+#include <stdint.h>
+
+#define __IO volatile
+
+typedef struct {
+	__IO uint32_t MODER;
+	__IO uint32_t OTYPER;
+	__IO uint32_t OSPEEDR;
+	__IO uint32_t PUPDR;
+	__IO uint32_t IDR;
+	__IO uint32_t ODR;
+	__IO uint32_t BSRR;
+	__IO uint32_t LCKR;
+	__IO uint32_t AFR[2];
+} GPIO_TypeDef;
+
+typedef struct {
+	__IO uint32_t AHB1ENR;
+	__IO uint32_t APB1ENR;
+	__IO uint32_t APB2ENR;
+	__IO uint32_t CFGR;
+} RCC_TypeDef;
+
+typedef struct {
+	__IO uint32_t MEMRMP;
+	__IO uint32_t PMC;
+	__IO uint32_t EXTICR[4];
+} SYSCFG_TypeDef;
+
+typedef struct {
+	__IO uint32_t IMR;
+	__IO uint32_t EMR;
+	__IO uint32_t RTSR;
+	__IO uint32_t FTSR;
+	__IO uint32_t SWIER;
+	__IO uint32_t PR;
+} EXTI_TypeDef;
+
+typedef enum {
+	EXTI1_IRQn = 7,
+	DMA2_Stream2_IRQn = 58
+} IRQn_Type;
+
+extern GPIO_TypeDef sim_GPIOA;
+extern GPIO_TypeDef sim_GPIOB;
+extern RCC_TypeDef sim_RCC;
+extern SYSCFG_TypeDef sim_SYSCFG;
+extern EXTI_TypeDef sim_EXTI;
+extern uint32_t SystemCoreClock;
+
+#define GPIOA	(&sim_GPIOA)
+#define GPIOB	(&sim_GPIOB)
+#define RCC		(&sim_RCC)
+#define SYSCFG	(&sim_SYSCFG)
+#define EXTI	(&sim_EXTI)
+
+#define GPIO_MODER_MODE0_0		(0x1UL << 0)
+#define GPIO_MODER_MODE1		(0x3UL << 2)
+#define GPIO_MODER_MODE8_0		(0x1UL << 16)
+#define GPIO_MODER_MODE8_1		(0x2UL << 16)
+#define GPIO_PUPDR_PUPD1		(0x3UL << 2)
+#define GPIO_PUPDR_PUPD1_0		(0x1UL << 2)
+#define GPIO_BSRR_BS8			(0x1UL << 8)
+#define GPIO_BSRR_BR8			(0x1UL << 24)
+#define RCC_AHB1ENR_GPIOAEN		(0x1UL << 0)
+#define RCC_AHB1ENR_GPIOBEN		(0x1UL << 1)
+#define RCC_APB2ENR_SYSCFGEN	(0x1UL << 14)
+#define SYSCFG_EXTICR1_EXTI1	(0xFUL << 4)
+#define SYSCFG_EXTICR1_EXTI1_PB	(0x1UL << 4)
+#define EXTI_IMR_MR1			(0x1UL << 1)
+#define EXTI_RTSR_TR1			(0x1UL << 1)
+#define EXTI_FTSR_TR1			(0x1UL << 1)
+#define EXTI_PR_PR1				(0x1UL << 1)
+
+/**
+ * @brief   Host version of WFI, the simulated core sleeps until the next SysTick interrupt or the completion
+ *          interrupt of a DMA transfer, whichever comes first.
+ *
+ * @param   None
+ *
+ * @return  None.
+ */
+void sim_wfi(void);
+
+#define __WFI()					sim_wfi()
+#define __disable_irq()
+#define __enable_irq()
+#define NVIC_EnableIRQ(irq)		((void) (irq))
+
+#endif /* __STM32F4XX_SIM_H */
@@ -0,0 +1,653 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   mfrc522_sim.c
+* @brief  A file defining the host-side behavioral model of the MFRC522 (register file, FIFO, COMM_IRQ,
+*         DIV_IRQ, ERROR and COLL semantics, timer, CRC coprocessor) and of ISO/IEC 14443A cards in its field.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 5, 2023
+* @revision 1.0
+*
+*/
+
+#include <string.h>
+#include "mfrc522_sim.h"
+#include "rfid.h"
+
+#define SIM_FC_HZ			13560000ULL	// RF carrier frequency
+#define SIM_BIT_NS			9440		// One bit at 106 kbit/s (128 / fc)
+#define SIM_FDT_NS			86430		// Frame delay time PCD to PICC (1172 / fc)
+#define SIM_AUTH_NS			600000		// Three pass authentication
+#define SIM_POWER_UP_NS		50000		// Oscillator restart after soft power-down
+#define SIM_MAX_BITS		(MFRC522_FIFO_SIZE * 8)
+
+#define PCD_SOFTRESET		0x0F
+
+/* States of ISO/IEC 14443-3 type A cards */
+typedef enum {
+	CARD_IDLE, CARD_READY, CARD_ACTIVE, CARD_HALT
+} sim_card_state_t;
+
+typedef struct {
+	bool present;
+	uint8_t uid[MFRC522_UID_MAX_SIZE];
+	uint8_t size;
+	uint8_t sak;
+	sim_card_state_t state;
+	uint8_t level;				// Cascade level while READY
+	int16_t auth_sector;		// Authenticated sector, -1 if none
+	int16_t write_block;		// Block waiting for the second write phase, -1 if none
+	uint8_t blocks[SIM_CARD_BLOCKS][MIFARE_BLOCK_SIZE];
+} sim_card_t;
+
+/* Result of the running command, applied to the registers once the simulated time reaches it */
+typedef struct {
+	bool active;
+	uint64_t at;
+	uint8_t comm_irq;
+	uint8_t div_irq;
+	uint8_t error;
+	uint8_t coll;
+	bool load_fifo;
+	uint8_t data[MFRC522_FIFO_SIZE];
+	uint8_t len;
+	uint8_t last_bits;
+	bool crypto;
+	bool crc;
+	uint16_t crc_value;
+} sim_pending_t;
+
+static uint8_t regs[64];
+static uint8_t fifo[MFRC522_FIFO_SIZE];
+static uint8_t fifo_len;
+static bool powered_down;
+static uint64_t ready_at;
+static sim_pending_t pending;
+static sim_card_t cards[SIM_MAX_CARDS];
+static uint32_t rf_frames;
+
+static bool spi_first;
+static uint8_t spi_addr;
+
+static uint8_t resp_bits[SIM_MAX_CARDS][SIM_MAX_BITS];
+static uint16_t resp_len[SIM_MAX_CARDS];
+static uint8_t resp_count;
+
+// Function to convert nanoseconds to core cycles
+static uint64_t sim_ns(uint64_t ns) {
+	return ns * SIM_CORE_HZ / 1000000000ULL;
+}
+
+// Function to calculate CRC_A bit by bit, independent from the table used by the driver
+static uint16_t sim_crc(const uint8_t *data, uint8_t len, uint16_t preset) {
+	uint16_t crc = preset;
+	uint8_t i;
+
+	while (len--) {
+		crc ^= *data++;
+		for (i = 0; i < 8; i++) {
+			crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+		}
+	}
+	return crc;
+}
+
+// Function to check the CRC_A trailing a frame
+static bool sim_crc_ok(const uint8_t *data, uint8_t len) {
+	uint16_t crc = sim_crc(data, len - 2, CRC_A_PRESET);
+	return (data[len - 2] == (crc & 0xFF)) && (data[len - 1] == (crc >> 8));
+}
+
+// Function to get the air time of a frame, parity bits and start/end of frame included
+static uint64_t sim_air_ns(uint16_t bits) {
+	if (bits < 8) {
+		return (bits + 2) * SIM_BIT_NS;
+	}
+	return (bits + bits / 8 + 2) * SIM_BIT_NS;
+}
+
+// Function to get the period of the RC522 timer
+static uint64_t sim_timer_ns(void) {
+	uint64_t prescaler = ((regs[MFRC522_REG_T_MODE] & 0x0F) << 8) | regs[MFRC522_REG_T_PRESCALER];
+	uint64_t reload = (regs[MFRC522_REG_T_RELOAD_H] << 8) | regs[MFRC522_REG_T_RELOAD_L];
+
+	return (2 * prescaler + 1) * (reload + 1) * 1000000000ULL / SIM_FC_HZ;
+}
+
+// Function to check whether the antenna drivers are on
+static bool sim_field_on(void) {
+	return (regs[MFRC522_REG_TX_CONTROL] & 0x03) && !powered_down;
+}
+
+// Function to reset every card that loses its supply when the field goes off
+static void sim_field_off(void) {
+	uint8_t c;
+
+	for (c = 0; c < SIM_MAX_CARDS; c++) {
+		cards[c].state = CARD_IDLE;
+		cards[c].auth_sector = -1;
+		cards[c].write_block = -1;
+	}
+}
+
+// Function to load the register reset values
+static void sim_soft_reset(void) {
+	memset(regs, 0, sizeof(regs));
+	regs[MFRC522_REG_COMMAND] = 0x20;
+	regs[MFRC522_REG_COMM_IE_N] = 0x80;
+	regs[MFRC522_REG_COMM_IRQ] = 0x14;
+	regs[MFRC522_REG_CONTROL] = 0x10;
+	regs[MFRC522_REG_COLL] = 0xA0;
+	regs[MFRC522_REG_MODE] = 0x3F;
+	regs[MFRC522_REG_TX_CONTROL] = 0x80;
+	regs[MFRC522_REG_VERSION] = 0x92;
+	fifo_len = 0;
+	pending.active = false;
+	sim_field_off();
+}
+
+// Function to apply the result of the running command once it is due
+static void sim_update(void) {
+	if (!pending.active || (sim_now() < pending.at)) {
+		return;
+	}
+
+	pending.active = false;
+	if (pending.load_fifo) {
+		memcpy(fifo, pending.data, pending.len);
+		fifo_len = pending.len;
+		regs[MFRC522_REG_CONTROL] = (regs[MFRC522_REG_CONTROL] & ~0x07) | pending.last_bits;
+		regs[MFRC522_REG_COLL] = (regs[MFRC522_REG_COLL] & 0x80) | pending.coll;
+	}
+	if (pending.crc) {
+		regs[MFRC522_REG_CRC_RESULT_L] = pending.crc_value & 0xFF;
+		regs[MFRC522_REG_CRC_RESULT_M] = pending.crc_value >> 8;
+	}
+	if (pending.crypto) {
+		regs[MFRC522_REG_STATUS2] |= 0x08;
+		regs[MFRC522_REG_COMMAND] &= ~0x0F;	// Authentication ends in Idle
+	}
+	regs[MFRC522_REG_ERROR] = pending.error;
+	regs[MFRC522_REG_COMM_IRQ] |= pending.comm_irq;
+	regs[MFRC522_REG_DIV_IRQ] |= pending.div_irq;
+}
+
+// Function to get the UID part and BCC a card sends at a cascade level
+static bool sim_card_cascade(const sim_card_t *card, uint8_t level, uint8_t *cl) {
+	uint8_t offset = 3 * (level - 1);
+	bool more = (card->size - offset) > 4;
+
+	if (more) {
+		cl[0] = PICC_CASCADE_TAG;
+		memcpy(&cl[1], &card->uid[offset], 3);
+	} else {
+		memcpy(cl, &card->uid[offset], 4);
+	}
+	cl[4] = cl[0] ^ cl[1] ^ cl[2] ^ cl[3];
+	return more;
+}
+
+// Function to queue the answer of one card, LSB first as sent on air
+static void sim_respond(const uint8_t *bytes, uint16_t first_bit, uint16_t bits) {
+	uint16_t i;
+
+	for (i = 0; i < bits; i++) {
+		uint16_t b = first_bit + i;
+		resp_bits[resp_count][i] = (bytes[b / 8] >> (b % 8)) & 1;
+	}
+	resp_len[resp_count] = bits;
+	resp_count++;
+}
+
+// Function to append a CRC_A to an answer and queue it
+static void sim_respond_crc(uint8_t *bytes, uint8_t len) {
+	uint16_t crc = sim_crc(bytes, len, CRC_A_PRESET);
+
+	bytes[len] = crc & 0xFF;
+	bytes[len + 1] = crc >> 8;
+	sim_respond(bytes, 0, (len + 2) * 8);
+}
+
+// Function to let every card in the field react to a frame
+static void sim_cards_process(const uint8_t *f, uint16_t nbits) {
+	uint8_t buff[MFRC522_MAX_LEN + 2];
+	uint8_t cl[5];
+	uint8_t c;
+	uint16_t known;
+	uint16_t i;
+
+	resp_count = 0;
+	for (c = 0; c < SIM_MAX_CARDS; c++) {
+		sim_card_t *card = &cards[c];
+
+		if (!card->present) {
+			continue;
+		}
+
+		// REQA and WUPA short frames
+		if (nbits == 7) {
+			uint8_t cmd = f[0] & 0x7F;
+			if (((cmd == PICC_REQIDL) && (card->state == CARD_IDLE))
+					|| ((cmd == PICC_REQALL) && ((card->state == CARD_IDLE) || (card->state == CARD_HALT)))) {
+				card->state = CARD_READY;
+				card->level = 1;
+				buff[0] = ((card->size == 4 ? 0 : card->size == 7 ? 1 : 2) << 6) | 0x04;
+				buff[1] = 0x00;
+				sim_respond(buff, 0, 16);
+			} else if (card->state != CARD_HALT) {
+				card->state = CARD_IDLE;
+			}
+			continue;
+		}
+
+		// Anti-collision and select of one cascade level
+		if (((f[0] == PICC_ANTICOLL) || (f[0] == PICC_SEL_CL2) || (f[0] == PICC_SEL_CL3)) && (nbits >= 16)) {
+			uint8_t level = 1 + (f[0] - PICC_ANTICOLL) / 2;
+			bool more;
+
+			if ((card->state != CARD_READY) || (card->level != level)) {
+				continue;
+			}
+			more = sim_card_cascade(card, level, cl);
+
+			if (f[1] == 0x70) {
+				if ((nbits != 72) || !sim_crc_ok(f, 9) || memcmp(cl, &f[2], 5)) {
+					continue;
+				}
+				buff[0] = more ? PICC_SAK_CASCADE : card->sak;
+				sim_respond_crc(buff, 1);
+				if (more) {
+					card->level++;
+				} else {
+					card->state = CARD_ACTIVE;
+				}
+				continue;
+			}
+
+			// Only cards whose UID starts with the bits sent take part
+			known = ((f[1] >> 4) - 2) * 8 + (f[1] & 0x07);
+			if ((known != nbits - 16) || (known >= 40)) {
+				continue;
+			}
+			for (i = 0; i < known; i++) {
+				if (((cl[i / 8] ^ f[2 + i / 8]) >> (i % 8)) & 1) {
+					break;
+				}
+			}
+			if (i == known) {
+				sim_respond(cl, known, 40 - known);
+			}
+			continue;
+		}
+
+		// HLTA
+		if ((f[0] == PICC_HALT) && (nbits == 32) && sim_crc_ok(f, 4)) {
+			if (card->state == CARD_ACTIVE) {
+				card->state = CARD_HALT;
+			} else if (card->state == CARD_READY) {
+				card->state = CARD_IDLE;
+			}
+			continue;
+		}
+
+		if (card->state == CARD_READY) {
+			card->state = CARD_IDLE;
+			continue;
+		}
+		if (card->state != CARD_ACTIVE) {
+			continue;
+		}
+
+		// Second phase of a write, the 16 data bytes
+		if (card->write_block >= 0) {
+			if ((nbits == (MIFARE_BLOCK_SIZE + 2) * 8) && sim_crc_ok(f, MIFARE_BLOCK_SIZE + 2)) {
+				memcpy(card->blocks[card->write_block], f, MIFARE_BLOCK_SIZE);
+				buff[0] = PICC_ACK;
+				sim_respond(buff, 0, 4);
+			} else {
+				card->state = CARD_IDLE;
+			}
+			card->write_block = -1;
+			continue;
+		}
+
+		// READ and WRITE inside the authenticated sector
+		if ((nbits == 32) && sim_crc_ok(f, 4) && (f[1] < SIM_CARD_BLOCKS)
+				&& (card->auth_sector == f[1] / 4) && (regs[MFRC522_REG_STATUS2] & 0x08)) {
+			if (f[0] == PICC_READ) {
+				memcpy(buff, card->blocks[f[1]], MIFARE_BLOCK_SIZE);
+				sim_respond_crc(buff, MIFARE_BLOCK_SIZE);
+				continue;
+			}
+			if (f[0] == PICC_WRITE) {
+				card->write_block = f[1];
+				buff[0] = PICC_ACK;
+				sim_respond(buff, 0, 4);
+				continue;
+			}
+		}
+
+		// Anything else is answered with silence and drops the card back to idle
+		card->state = CARD_IDLE;
+		card->auth_sector = -1;
+	}
+}
+
+// Function to merge the answers of all cards the way the receiver sees them
+static void sim_receive(uint8_t rxAlign) {
+	uint8_t merged[SIM_MAX_BITS];
+	uint16_t bits = resp_len[0];
+	uint16_t collPos = 0;
+	uint16_t i;
+	uint16_t pos;
+	uint8_t c;
+
+	for (i = 0; i < bits; i++) {
+		merged[i] = resp_bits[0][i];
+		for (c = 1; c < resp_count; c++) {
+			if (resp_bits[c][i] != merged[i]) {
+				break;
+			}
+		}
+		if ((c != resp_count) && (collPos == 0)) {
+			collPos = i + 1;
+		}
+		// ValuesAfterColl = 0 clears every bit from the collision on
+		if (collPos && !(regs[MFRC522_REG_COLL] & 0x80)) {
+			merged[i] = 0;
+		}
+	}
+
+	// The first received bit is stored at bit position RxAlign of the first FIFO byte
+	memset(pending.data, 0, sizeof(pending.data));
+	for (i = 0; (i < bits) && (rxAlign + i < SIM_MAX_BITS); i++) {
+		pos = rxAlign + i;
+		pending.data[pos / 8] |= merged[i] << (pos % 8);
+	}
+	pending.len = (rxAlign + bits + 7) / 8;
+	pending.last_bits = (rxAlign + bits) % 8;
+	pending.load_fifo = true;
+
+	// CollPos counts from the first received bit, 0 stands for bit 32
+	if (collPos) {
+		pending.error = MFRC522_ERR_COLL;
+		pending.coll = collPos & 0x1F;
+	} else {
+		pending.coll = 0x20;	// CollPosNotValid
+	}
+}
+
+// Function to send the FIFO contents to the field and schedule the answer
+static void sim_transceive(void) {
+	uint8_t frame[MFRC522_FIFO_SIZE];
+	uint8_t txLastBits = regs[MFRC522_REG_BIT_FRAMING] & 0x07;
+	uint8_t rxAlign = (regs[MFRC522_REG_BIT_FRAMING] >> 4) & 0x07;
+	uint16_t nbits = fifo_len * 8 - (txLastBits ? 8 - txLastBits : 0);
+	uint64_t tx_end;
+
+	memcpy(frame, fifo, fifo_len);
+	fifo_len = 0;
+	rf_frames++;
+
+	memset(&pending, 0, sizeof(pending));
+	regs[MFRC522_REG_ERROR] = 0;
+	tx_end = sim_now() + sim_ns(sim_air_ns(nbits));
+
+	resp_count = 0;
+	if (sim_field_on() && (nbits != 0)) {
+		sim_cards_process(frame, nbits);
+	}
+
+	pending.active = true;
+	if (resp_count) {
+		sim_receive(rxAlign);
+		pending.at = tx_end + sim_ns(SIM_FDT_NS + sim_air_ns(resp_len[0]));
+		pending.comm_irq = 0x40 | 0x20 | (pending.error ? 0x02 : 0); // TxIRq, RxIRq, ErrIRq
+	} else if (regs[MFRC522_REG_T_MODE] & 0x80) {
+		pending.at = tx_end + sim_ns(sim_timer_ns());
+		pending.comm_irq = 0x40 | 0x01; // TxIRq, TimerIRq
+	} else {
+		pending.at = tx_end;
+		pending.comm_irq = 0x40; // Without TAuto nothing ends the command
+	}
+}
+
+// Function to run the MIFARE authentication with the card selected in the field
+static void sim_authent(void) {
+	static const uint8_t transport_key[MIFARE_KEY_SIZE] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+	uint8_t c;
+
+	memset(&pending, 0, sizeof(pending));
+	pending.active = true;
+	rf_frames++;
+
+	for (c = 0; c < SIM_MAX_CARDS; c++) {
+		sim_card_t *card = &cards[c];
+		if (card->present && (card->state == CARD_ACTIVE) && (fifo_len == 12)
+				&& ((fifo[0] == PICC_AUTH_KEYA) || (fifo[0] == PICC_AUTH_KEYB))
+				&& (fifo[1] < SIM_CARD_BLOCKS) && sim_field_on()
+				&& !memcmp(&fifo[2], transport_key, MIFARE_KEY_SIZE)
+				&& !memcmp(&fifo[8], &card->uid[card->size - 4], 4)) {
+			card->auth_sector = fifo[1] / 4;
+			pending.at = sim_now() + sim_ns(SIM_AUTH_NS);
+			pending.comm_irq = 0x10; // IdleIRq
+			pending.crypto = true;
+			fifo_len = 0;
+			return;
+		}
+	}
+
+	// No card answered the authentication, only the timer ends it
+	fifo_len = 0;
+	pending.at = sim_now() + sim_ns(SIM_AUTH_NS / 3 + sim_timer_ns());
+	pending.comm_irq = (regs[MFRC522_REG_T_MODE] & 0x80) ? 0x01 : 0x00;
+}
+
+// Function to run the CRC coprocessor on the FIFO contents
+static void sim_calc_crc(void) {
+	static const uint16_t presets[4] = { 0x0000, 0x6363, 0xA671, 0xFFFF };
+
+	memset(&pending, 0, sizeof(pending));
+	pending.active = true;
+	pending.crc = true;
+	pending.crc_value = sim_crc(fifo, fifo_len, presets[regs[MFRC522_REG_MODE] & 0x03]);
+	pending.div_irq = 0x04; // CRCIRq
+	pending.at = sim_now() + sim_ns(1000 + fifo_len * 600);
+	fifo_len = 0;
+}
+
+// Function to read a register of the model
+static uint8_t sim_reg_read(uint8_t reg) {
+	uint8_t value;
+
+	sim_update();
+	switch (reg) {
+	case MFRC522_REG_FIFO_DATA:
+		if (fifo_len == 0) {
+			return 0;
+		}
+		value = fifo[0];
+		memmove(fifo, &fifo[1], --fifo_len);
+		return value;
+	case MFRC522_REG_FIFO_LEVEL:
+		return fifo_len;
+	case MFRC522_REG_COMMAND:
+		value = regs[reg] & ~0x10;
+		if (powered_down || (sim_now() < ready_at)) {
+			value |= 0x10;
+		}
+		return value;
+	default:
+		return regs[reg];
+	}
+}
+
+// Function to write a register of the model
+static void sim_reg_write(uint8_t reg, uint8_t value) {
+	bool field;
+
+	sim_update();
+	switch (reg) {
+	case MFRC522_REG_COMMAND:
+		if (value & 0x10) {
+			powered_down = true;
+			pending.active = false;
+			regs[reg] = value & 0x3F;
+			sim_field_off();
+			return;
+		}
+		if (powered_down) {
+			powered_down = false;
+			ready_at = sim_now() + sim_ns(SIM_POWER_UP_NS);
+		}
+		regs[reg] = value & 0x2F;
+		switch (value & 0x0F) {
+		case PCD_IDLE:
+			pending.active = false;
+			break;
+		case PCD_CALCCRC:
+			sim_calc_crc();
+			break;
+		case PCD_AUTHENT:
+			sim_authent();
+			break;
+		case PCD_TRANSCEIVE:
+			if (regs[MFRC522_REG_BIT_FRAMING] & 0x80) {
+				sim_transceive();
+			}
+			break;
+		case PCD_SOFTRESET:
+			sim_soft_reset();
+			break;
+		default:
+			break;
+		}
+		return;
+	case MFRC522_REG_COMM_IRQ:
+	case MFRC522_REG_DIV_IRQ:
+		// Set1/Set2 decides whether the marked bits are set or cleared
+		if (value & 0x80) {
+			regs[reg] |= value & 0x7F;
+		} else {
+			regs[reg] &= ~(value & 0x7F);
+		}
+		return;
+	case MFRC522_REG_FIFO_DATA:
+		if (fifo_len < MFRC522_FIFO_SIZE) {
+			fifo[fifo_len++] = value;
+		}
+		return;
+	case MFRC522_REG_FIFO_LEVEL:
+		if (value & 0x80) {
+			fifo_len = 0;
+		}
+		return;
+	case MFRC522_REG_BIT_FRAMING:
+		regs[reg] = value;
+		if ((value & 0x80) && ((regs[MFRC522_REG_COMMAND] & 0x0F) == PCD_TRANSCEIVE)) {
+			sim_transceive();
+		}
+		return;
+	case MFRC522_REG_STATUS2:
+		// MFCrypto1On can only be cleared by software
+		regs[reg] &= (value | ~0x08);
+		return;
+	case MFRC522_REG_COLL:
+		regs[reg] = (regs[reg] & 0x7F) | (value & 0x80);
+		return;
+	case MFRC522_REG_ERROR:
+	case MFRC522_REG_CONTROL:
+	case MFRC522_REG_VERSION:
+		return;
+	case MFRC522_REG_TX_CONTROL:
+		field = sim_field_on();
+		regs[reg] = value;
+		if (field && !sim_field_on()) {
+			sim_field_off();
+		}
+		return;
+	default:
+		regs[reg] = value;
+		return;
+	}
+}
+
+// Function to put the model into its power-on state
+void mfrc522_sim_reset(void) {
+	memset(cards, 0, sizeof(cards));
+	powered_down = false;
+	ready_at = 0;
+	rf_frames = 0;
+	sim_soft_reset();
+}
+
+// Function to start a new SPI frame
+void mfrc522_sim_spi_begin(void) {
+	spi_first = true;
+}
+
+// Function to exchange one SPI byte, a read answers the address sent with the previous byte
+uint8_t mfrc522_sim_spi_byte(uint8_t tx) {
+	uint8_t rx = 0;
+	uint8_t reg = (spi_addr >> 1) & 0x3F;
+
+	if (spi_first) {
+		spi_first = false;
+		spi_addr = tx;
+		return 0;
+	}
+
+	if (spi_addr & 0x80) {
+		rx = sim_reg_read(reg);
+		spi_addr = tx;
+	} else {
+		sim_reg_write(reg, tx);
+	}
+	return rx;
+}
+
+// Function to place a card in the field
+int8_t mfrc522_sim_add_card(const uint8_t *uid, uint8_t size, uint8_t sak) {
+	int8_t c;
+
+	for (c = 0; c < SIM_MAX_CARDS; c++) {
+		if (!cards[c].present) {
+			memset(&cards[c], 0, sizeof(cards[c]));
+			cards[c].present = true;
+			memcpy(cards[c].uid, uid, size);
+			cards[c].size = size;
+			cards[c].sak = sak;
+			cards[c].state = CARD_IDLE;
+			cards[c].auth_sector = -1;
+			cards[c].write_block = -1;
+			return c;
+		}
+	}
+	return -1;
+}
+
+// Function to take a card out of the field
+void mfrc522_sim_remove_card(int8_t card) {
+	if ((card >= 0) && (card < SIM_MAX_CARDS)) {
+		cards[card].present = false;
+	}
+}
+
+// Function to access the memory of a card
+uint8_t* mfrc522_sim_card_block(int8_t card, uint8_t block) {
+	return cards[card].blocks[block % SIM_CARD_BLOCKS];
+}
+
+// Function to get the number of RF frames sent
+uint32_t mfrc522_sim_rf_frames(void) {
+	return rf_frames;
+}
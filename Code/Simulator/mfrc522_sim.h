@@ -0,0 +1,138 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   mfrc522_sim.h
+* @brief  A file declaring the host-side behavioral model of the MFRC522 and of the cards in its field.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 5, 2023
+* @revision 1.0
+*
+*/
+
+#ifndef __MFRC522_SIM_H
+#define __MFRC522_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SIM_CORE_HZ			16000000	// Simulated core clock, SPI1 runs from the same clock (APB2 prescaler 1)
+#define SIM_MAX_CARDS		8
+#define SIM_CARD_BLOCKS		64			// MIFARE Classic 1K
+#define SIM_SPI_OVERHEAD	40			// Core cycles spent around each SPI transaction
+#define SIM_SPI_POLL_BYTE	12			// Core cycles of the polled loop per byte (TXE/RXNE polls, DR access)
+#define SIM_DMA_SETUP		96			// Core cycles to stop, program and start both DMA streams
+#define SIM_DMA_IRQ			48			// Core cycles of the DMA completion interrupt, entry and exit included
+
+/**
+ * @brief   A function to get the simulated time.
+ *
+ * @param   None
+ *
+ * @return  Core cycles since the simulation started.
+ */
+uint64_t sim_now(void);
+
+/**
+ * @brief   A function to advance the simulated time.
+ *
+ * @param   count Core cycles to add
+ *
+ * @return  None.
+ */
+void sim_advance(uint64_t count);
+
+/**
+ * @brief   A function to schedule a peripheral interrupt, WFI wakes up at that time when it comes before the
+ *          next SysTick interrupt.
+ *
+ * @param   cycle Simulated time of the interrupt in core cycles
+ *
+ * @return  None.
+ */
+void sim_wake_at(uint64_t cycle);
+
+/**
+ * @brief   A function to get the number of SPI transfers run by the DMA engine.
+ *
+ * @param   None
+ *
+ * @return  Transfers started by spi_transfer_async().
+ */
+uint32_t spi_sim_dma_count(void);
+
+/**
+ * @brief   A function to put the MFRC522 model into its power-on state and remove every card.
+ *
+ * @param   None
+ *
+ * @return  None.
+ */
+void mfrc522_sim_reset(void);
+
+/**
+ * @brief   A function to start a new SPI frame, as done by the falling edge of chip-select.
+ *
+ * @param   None
+ *
+ * @return  None.
+ */
+void mfrc522_sim_spi_begin(void);
+
+/**
+ * @brief   A function to exchange one byte with the MFRC522 model inside the current SPI frame.
+ *
+ * @param   tx Byte on MOSI
+ *
+ * @return  Byte on MISO.
+ */
+uint8_t mfrc522_sim_spi_byte(uint8_t tx);
+
+/**
+ * @brief   A function to place a card in the field.
+ *
+ * @param   uid  Pointer to the UID
+ *          size UID size, 4, 7 or 10 bytes
+ *          sak  SAK of the last cascade level (0x08 MIFARE Classic 1K, 0x00 NTAG, 0x20 DESFire)
+ *
+ * @return  Card handle, -1 if the field is full.
+ */
+int8_t mfrc522_sim_add_card(const uint8_t *uid, uint8_t size, uint8_t sak);
+
+/**
+ * @brief   A function to take a card out of the field.
+ *
+ * @param   card Card handle
+ *
+ * @return  None.
+ */
+void mfrc522_sim_remove_card(int8_t card);
+
+/**
+ * @brief   A function to access the memory of a card, every sector uses the transport key FF FF FF FF FF FF.
+ *
+ * @param   card  Card handle
+ *          block Block address
+ *
+ * @return  Pointer to the 16 byte block.
+ */
+uint8_t* mfrc522_sim_card_block(int8_t card, uint8_t block);
+
+/**
+ * @brief   A function to get the number of RF frames the MFRC522 model has sent to the field.
+ *
+ * @param   None
+ *
+ * @return  Frame count.
+ */
+uint32_t mfrc522_sim_rf_frames(void);
+
+#endif /* __MFRC522_SIM_H */
@@ -0,0 +1,71 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   pin_gen.c
+* @brief  A host program hashing a PIN for the firmware. It draws a salt from /dev/urandom and prints the
+*         pin_hash_t definition to paste into security_system_interface.c, e.g. "./pin_gen admin_password 1234".
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 17, 2023
+* @revision 1.0
+*
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "pin.h"
+
+// Function to print a byte array as a C initializer
+static void print_bytes(const uint8_t *bytes, int size) {
+	int i;
+
+	printf("{ ");
+	for (i = 0; i < size; i++) {
+		printf("0x%02X%s", bytes[i], (i + 1 == size) ? " }" : ((i % 16 == 15) ? ",\r\n\t\t  " : ", "));
+	}
+}
+
+int main(int argc, char **argv) {
+	uint8_t salt[PIN_SALT_SIZE];
+	pin_hash_t stored;
+	FILE *random;
+	const char *p;
+
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s <name> <pin>\n", argv[0]);
+		return 1;
+	}
+	for (p = argv[2]; *p; p++) {
+		if ((*p < '0') || (*p > '9')) {
+			fprintf(stderr, "The keypad only enters digits\n");
+			return 1;
+		}
+	}
+	if (strlen(argv[2]) > PIN_MAX_LENGTH) {
+		fprintf(stderr, "A PIN has at most %d digits\n", PIN_MAX_LENGTH);
+		return 1;
+	}
+
+	random = fopen("/dev/urandom", "rb");
+	if (!random || (fread(salt, 1, sizeof(salt), random) != sizeof(salt))) {
+		fprintf(stderr, "No random salt\n");
+		return 1;
+	}
+	fclose(random);
+
+	pin_hash(argv[2], salt, &stored);
+	printf("static const pin_hash_t %s = {\r\n\t\t", argv[1]);
+	print_bytes(stored.salt, PIN_SALT_SIZE);
+	printf(",\r\n\t\t");
+	print_bytes(stored.hash, SHA256_DIGEST_SIZE);
+	printf(" };\r\n");
+	return 0;
+}
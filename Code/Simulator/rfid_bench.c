@@ -0,0 +1,1015 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   rfid_bench.c
+* @brief  A host program running the unchanged RC522 driver against the MFRC522 model. Every scenario
+*         reports its SPI transactions, RF frames and simulated time, and checks the cards read back.
+*         The exit status is the number of failed checks so the program can gate a CI job.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 5, 2023
+* @revision 1.0
+*
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include "stm32f4xx.h"
+#include "rfid.h"
+#include "spi.h"
+#include "delay.h"
+#include "mfrc522_sim.h"
+#include "rfid_trace.h"
+#include "debug_log.h"
+#include "credentials.h"
+#include "whitelist.h"
+#include "bloom_filter.h"
+#include "credential_store.h"
+#include "flash.h"
+#include "flash_sim.h"
+#include "journal.h"
+#include "scheduler.h"
+#include "sha256.h"
+#include "pin.h"
+
+#define BENCH_POLL_EMPTY_US		2000	// Budget of one RC522_poll_events() call on an empty field
+#define BENCH_POLL_CARD_US		8000	// Budget with a double size UID card held, set by the RF frames of one read
+
+/* Counters at the start of a measured scenario */
+typedef struct {
+	uint32_t spi;
+	uint32_t frames;
+	uint64_t cycles;
+} bench_mark_t;
+
+static int failures = 0;
+
+static const uint8_t uid_single[4] = { 0xE3, 0x9A, 0x9F, 0x0B };
+static const uint8_t uid_single_2[4] = { 0x23, 0xA2, 0xA2, 0xC5 };
+static const uint8_t uid_double[7] = { 0x04, 0x5A, 0x2C, 0x32, 0x6B, 0x70, 0x80 };
+static const uint8_t uid_triple[10] = { 0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99 };
+// Bits 1 and 2 differ, the second collision falls inside the partially known first byte
+static const uint8_t uid_tree[3][4] = { { 0x00, 0x11, 0x22, 0x33 }, { 0x02, 0x11, 0x22, 0x33 },
+		{ 0x06, 0x11, 0x22, 0x33 } };
+// Only bit 32 differs, the collision leaves no bits of the BCC to receive
+static const uint8_t uid_last_bit[2][4] = { { 0x10, 0x20, 0x30, 0x40 }, { 0x10, 0x20, 0x30, 0xC0 } };
+
+// Function to record the counters at the start of a scenario
+static void bench_start(bench_mark_t *mark) {
+	mark->spi = spi_get_transaction_count();
+	mark->frames = mfrc522_sim_rf_frames();
+	mark->cycles = sim_now();
+}
+
+// Function to print the cost of a scenario
+static void bench_report(const char *name, const bench_mark_t *mark, uint32_t runs) {
+	uint64_t cycles = sim_now() - mark->cycles;
+
+	printf("%-40s %8.1f SPI %6.1f RF %10.1f us\r\n", name,
+			(double) (spi_get_transaction_count() - mark->spi) / runs,
+			(double) (mfrc522_sim_rf_frames() - mark->frames) / runs,
+			(double) cycles * 1000000.0 / SIM_CORE_HZ / runs);
+}
+
+// Function to record the result of a check
+static void bench_check(bool ok, const char *what) {
+	if (!ok) {
+		printf("FAIL: %s\r\n", what);
+		failures++;
+	}
+}
+
+// Function to check that a UID is in a list of UIDs
+static bool bench_uid_found(const RC522_uid_t *uids, uint8_t count, const uint8_t *uid, uint8_t size) {
+	uint8_t c;
+
+	for (c = 0; c < count; c++) {
+		if ((uids[c].size == size) && !memcmp(uids[c].uid, uid, size)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Function to read the field once with a given set of cards and check every UID comes back
+static void bench_inventory(const char *name, const uint8_t *const *uids, const uint8_t *sizes,
+		uint8_t count) {
+	RC522_uid_t found[MFRC522_INVENTORY_MAX];
+	int8_t handle[SIM_MAX_CARDS];
+	bench_mark_t mark;
+	uint8_t n;
+	uint8_t c;
+
+	for (c = 0; c < count; c++) {
+		handle[c] = mfrc522_sim_add_card(uids[c], sizes[c], sizes[c] == 4 ? 0x08 : 0x00);
+	}
+
+	bench_start(&mark);
+	n = RC522_inventory(PICC_REQIDL, found, MFRC522_INVENTORY_MAX);
+	bench_report(name, &mark, 1);
+
+	bench_check(n == count, name);
+	for (c = 0; c < count; c++) {
+		bench_check(bench_uid_found(found, n, uids[c], sizes[c]), name);
+		mfrc522_sim_remove_card(handle[c]);
+	}
+}
+
+// Function to measure MIFARE Classic authentication and block access
+static void bench_mifare(void) {
+	static const uint8_t key[MIFARE_KEY_SIZE] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+	static const uint8_t record[MIFARE_BLOCK_SIZE] = { 'P', 'I', 'N', 0x5A, 0xA5, 0x12, 0x34, 0x56,
+			0x20, 0x24, 0x12, 0x31, 0x00, 0x00, 0x00, 0x01 };
+	uint8_t data[MIFARE_BLOCK_SIZE];
+	RC522_uid_t uid;
+	bench_mark_t mark;
+	int8_t card;
+	uint8_t block;
+	uint32_t dma;
+	bool ok = true;
+
+	card = mfrc522_sim_add_card(uid_single, 4, 0x08);
+	memcpy(mfrc522_sim_card_block(card, 4), record, MIFARE_BLOCK_SIZE);
+
+	dma = spi_sim_dma_count();
+	bench_check(RC522_request(PICC_REQIDL, data) && RC522_select(&uid), "MIFARE select");
+	// The 9 byte SELECT frame goes through DMA, the 1 byte REQA and the short answers are polled
+	bench_check(spi_sim_dma_count() == dma + 1, "FIFO bursts from MFRC522_DMA_MIN_BURST bytes use DMA");
+
+	bench_start(&mark);
+	bench_check(RC522_auth(PICC_AUTH_KEYA, 4, key, &uid), "MIFARE auth");
+	bench_report("MIFARE authenticate", &mark, 1);
+
+	bench_start(&mark);
+	bench_check(RC522_read_block(4, data) && !memcmp(data, record, MIFARE_BLOCK_SIZE), "MIFARE read");
+	bench_report("MIFARE read block", &mark, 1);
+
+	bench_start(&mark);
+	for (block = 4; block < 7; block++) {
+		ok &= RC522_read_block(block, data);
+	}
+	bench_report("MIFARE read block (sector, per block)", &mark, 3);
+	bench_check(ok, "MIFARE sector read");
+
+	memset(data, 0x42, sizeof(data));
+	dma = spi_sim_dma_count();
+	bench_start(&mark);
+	bench_check(RC522_write_block(5, data) && (spi_sim_dma_count() > dma), "MIFARE write");
+	bench_report("MIFARE write block", &mark, 1);
+	bench_check(!memcmp(mfrc522_sim_card_block(card, 5), data, MIFARE_BLOCK_SIZE), "MIFARE write data");
+
+	bench_check(!RC522_read_block(8, data), "MIFARE read outside the sector");
+
+	RC522_halt();
+	RC522_stop_crypto1();
+	mfrc522_sim_remove_card(card);
+}
+
+// Function to check that a held card produces a single presented/removed pair
+static void bench_events(void) {
+	RC522_event_t events[MFRC522_EVENTS_MAX];
+	bench_mark_t mark;
+	uint32_t presented = 0;
+	uint32_t removed = 0;
+	uint32_t polls = 0;
+	uint32_t start;
+	uint64_t poll_start;
+	uint64_t worst[2] = { 0, 0 };
+	uint8_t n;
+	uint8_t e;
+	int8_t card;
+	bool busy = true;
+
+	card = mfrc522_sim_add_card(uid_double, 7, 0x00);
+	bench_start(&mark);
+	start = millis();
+	while (millis() - start < 2000) {
+		if (millis() - start >= 1000) {
+			mfrc522_sim_remove_card(card);
+		}
+		// Worst case of one call with the card held and with an empty field, the access task makes this call
+		e = (millis() - start >= 1000);
+		poll_start = sim_now();
+		n = RC522_poll_events(events, MFRC522_EVENTS_MAX);
+		if (sim_now() - poll_start > worst[e]) {
+			worst[e] = sim_now() - poll_start;
+		}
+		for (e = 0; e < n; e++) {
+			if (events[e].type == RC522_EVENT_PRESENTED) {
+				presented++;
+			} else {
+				removed++;
+			}
+		}
+		// The journal erase waits while the held card is on the reader
+		if (presented && (millis() - start < 1000)) {
+			busy &= RC522_field_busy();
+		}
+		polls++;
+	}
+	bench_report("Event poll, card held 1s (per poll)", &mark, polls);
+	bench_check((presented == 1) && (removed == 1), "Single presented/removed pair");
+	bench_check(busy && !RC522_field_busy(), "Field busy only while a card is held");
+	printf("Event poll worst case %.1f us with a card, %.1f us without\r\n",
+			(double) worst[0] * 1000000 / SIM_CORE_HZ, (double) worst[1] * 1000000 / SIM_CORE_HZ);
+	bench_check(worst[0] < cycles_from_us(BENCH_POLL_CARD_US), "Event poll with a card within its latency budget");
+	bench_check(worst[1] < cycles_from_us(BENCH_POLL_EMPTY_US), "Event poll without a card within its latency budget");
+}
+
+// Function to check a detection slot runs only once it is due and the call returns at once in between
+static void bench_lpcd(void) {
+	const RC522_lpcd_stats_t *stats = RC522_lpcd_get_stats();
+	RC522_uid_t found[MFRC522_INVENTORY_MAX];
+	uint32_t slots = stats->slots;
+	uint32_t start;
+	uint64_t cycles_start;
+	uint8_t n = 0;
+	int8_t card;
+
+	RC522_lpcd_set_interval(MFRC522_LPCD_INTERVAL_MS);
+	bench_check(RC522_lpcd_poll(found, MFRC522_INVENTORY_MAX) == 0, "LPCD empty slot");
+	bench_check(stats->slots == slots + 1, "LPCD slot run");
+
+	cycles_start = sim_now();
+	bench_check(RC522_lpcd_poll(found, MFRC522_INVENTORY_MAX) == 0, "LPCD slot not due");
+	bench_check((stats->slots == slots + 1) && (sim_now() - cycles_start < cycles_from_us(10)),
+			"LPCD returns at once before the next slot");
+
+	// Sleep between calls as the scheduler does, the card is found in the next slot
+	card = mfrc522_sim_add_card(uid_single, 4, 0x08);
+	start = millis();
+	while ((n == 0) && (millis() - start <= MFRC522_LPCD_INTERVAL_MS)) {
+		__WFI();
+		n = RC522_lpcd_poll(found, MFRC522_INVENTORY_MAX);
+	}
+	bench_check((n == 1) && bench_uid_found(found, n, uid_single, 4), "LPCD card found in the next slot");
+	bench_check(stats->slots == slots + 2, "LPCD one slot per interval");
+	printf("LPCD empty slot %lu us awake every %lu ms\r\n", (unsigned long) stats->active_us_last,
+			(unsigned long) stats->interval_ms);
+
+	mfrc522_sim_remove_card(card);
+
+	// The average current comes from the mean powered time of ten empty slots, the latency from the longest one
+	start = millis();
+	while (millis() - start < 10 * MFRC522_LPCD_INTERVAL_MS) {
+		__WFI();
+		RC522_lpcd_poll(found, MFRC522_INVENTORY_MAX);
+	}
+	RC522_lpcd_get_stats();
+	bench_check((stats->empty_slots != 0) && (stats->active_us_sum / stats->empty_slots <= stats->active_us_max),
+			"LPCD mean empty slot");
+	printf("LPCD %lu empty slots, mean %lu us, worst %lu us: %lu uA average, %lu ms worst latency\r\n",
+			(unsigned long) stats->empty_slots, (unsigned long) (stats->active_us_sum / stats->empty_slots),
+			(unsigned long) stats->active_us_max, (unsigned long) stats->avg_current_ua,
+			(unsigned long) stats->worst_latency_ms);
+}
+
+// Function to print driver output on stdout
+static void bench_write(char *text) {
+	fputs(text, stdout);
+}
+
+// Function to make the n-th test UID, half single size and half double size
+static uint8_t bench_make_uid(uint32_t n, uint32_t salt, uint8_t *uid) {
+	uint32_t x = (n + 1) * 2654435761U ^ salt;
+	uint8_t size = (n & 1) ? 7 : 4;
+	uint8_t i;
+
+	for (i = 0; i < size; i++) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		uid[i] = x;
+	}
+	if (size == 7) {
+		uid[0] = 0x04;	// NXP manufacturer code, the first byte of a double size UID carries no entropy
+	}
+	return size;
+}
+
+// Function to get the host time in nanoseconds
+static uint64_t bench_host_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000U + ts.tv_nsec;
+}
+
+// Function to measure credential lookups of known and unknown cards with a given number of cards stored
+static void bench_credentials(uint32_t cards) {
+	const credentials_stats_t *stats = credentials_get_stats();
+	const pool_stats_t *pool = credentials_get_pool_stats();
+	uint8_t uid[MFRC522_UID_MAX_SIZE];
+	uint8_t size;
+	uint32_t probes;
+	uint32_t hits = 0;
+	uint32_t misses = 0;
+	uint64_t start;
+	uint64_t hit_ns;
+	uint32_t n;
+
+	credentials_clear();
+	for (n = 0; n < cards; n++) {
+		size = bench_make_uid(n, 0, uid);
+		bench_check(credentials_add(uid, size), "Credential add");
+	}
+
+	probes = stats->probes;
+	start = bench_host_ns();
+	for (n = 0; n < cards; n++) {
+		size = bench_make_uid(n, 0, uid);
+		hits += credentials_find(uid, size);
+	}
+	hit_ns = bench_host_ns() - start;
+	printf("Credential lookup, %5lu cards, known   %6.2f probes %8.1f host ns\r\n", (unsigned long) cards,
+			(double) (stats->probes - probes) / cards, (double) hit_ns / cards);
+
+	probes = stats->probes;
+	start = bench_host_ns();
+	for (n = 0; n < cards; n++) {
+		size = bench_make_uid(n, 0x5A5A5A5A, uid);
+		misses += !credentials_find(uid, size);
+	}
+	printf("Credential lookup, %5lu cards, unknown %6.2f probes %8.1f host ns\r\n", (unsigned long) cards,
+			(double) (stats->probes - probes) / cards, (double) (bench_host_ns() - start) / cards);
+	bench_check((hits == cards) && (misses == cards), "Credential lookup");
+
+	// Removing every other card must leave the rest reachable
+	for (n = 0; n < cards; n += 2) {
+		size = bench_make_uid(n, 0, uid);
+		bench_check(credentials_remove(uid, size), "Credential remove");
+	}
+	hits = 0;
+	for (n = 0; n < cards; n++) {
+		size = bench_make_uid(n, 0, uid);
+		hits += (credentials_find(uid, size) == (n & 1));
+	}
+	bench_check(hits == cards, "Credential lookup after remove");
+	bench_check((pool->used == cards / 2) && (pool->peak == cards) && (pool->failures == 0), "Credential pool");
+}
+
+// Function to fill the credential record pool and check it refuses the card after the last block
+static void bench_credential_pool(void) {
+	const pool_stats_t *pool = credentials_get_pool_stats();
+	uint32_t blocks[4];
+	uint32_t used[POOL_USED_WORDS(4)];
+	pool_t small = POOL_INIT(blocks, used);
+	uint16_t a;
+	uint16_t b;
+	uint8_t uid[MFRC522_UID_MAX_SIZE];
+	uint8_t size;
+	uint32_t n;
+	bool ok = true;
+
+	credentials_clear();
+	for (n = 0; n < pool->blocks; n++) {
+		size = bench_make_uid(n, 0, uid);
+		ok &= credentials_add(uid, size);
+	}
+	size = bench_make_uid(n, 0, uid);
+	bench_check(ok && !credentials_add(uid, size) && (pool->used == pool->blocks) && (pool->failures == 1),
+			"Credential pool full");
+
+	// A freed record is reused by the next card
+	size = bench_make_uid(0, 0, uid);
+	ok = credentials_remove(uid, size);
+	size = bench_make_uid(n, 0, uid);
+	bench_check(ok && credentials_add(uid, size) && (pool->used == pool->blocks), "Credential pool reuse");
+	printf("Credential pool, %lu records of %u bytes, %lu table slots of 2 bytes\r\n", (unsigned long) pool->blocks,
+			(unsigned int) (MFRC522_UID_MAX_SIZE + 1), (unsigned long) CREDENTIALS_CAPACITY);
+
+	// A block freed twice, or never allocated, is refused and the next allocations still get distinct blocks
+	pool_reset(&small);
+	a = pool_alloc(&small);
+	pool_free(&small, a);
+	pool_free(&small, a);
+	pool_free(&small, 3);
+	a = pool_alloc(&small);
+	b = pool_alloc(&small);
+	bench_check((a != b) && (small.stats.used == 2) && (small.stats.failures == 2), "Pool double free");
+}
+
+// Function to measure lookups in the generated whitelist (bench_whitelist.c)
+static void bench_whitelist(void) {
+	uint8_t uid[MFRC522_UID_MAX_SIZE];
+	uint8_t size;
+	uint32_t hits = 0;
+	uint32_t misses = 0;
+	uint64_t start;
+	uint32_t n;
+
+	start = bench_host_ns();
+	for (n = 0; n < whitelist.count; n++) {
+		hits += whitelist_find(&whitelist, whitelist.uids[n].uid, whitelist.uids[n].size);
+	}
+	printf("Whitelist lookup,  %5lu cards, known   %6.2f probes %8.1f host ns\r\n",
+			(unsigned long) whitelist.count, 1.0, (double) (bench_host_ns() - start) / whitelist.count);
+
+	start = bench_host_ns();
+	for (n = 0; n < whitelist.count; n++) {
+		size = bench_make_uid(n, 0x5A5A5A5A, uid);
+		misses += !whitelist_find(&whitelist, uid, size);
+	}
+	printf("Whitelist lookup,  %5lu cards, unknown %6.2f probes %8.1f host ns\r\n",
+			(unsigned long) whitelist.count, 1.0, (double) (bench_host_ns() - start) / whitelist.count);
+	bench_check((hits == whitelist.count) && (misses == whitelist.count), "Whitelist lookup");
+}
+
+// Function to measure the Bloom filter in front of the whitelist, memory against false positives and reject time
+static void bench_bloom(uint32_t size, uint8_t hashes) {
+	static uint32_t storage[1 << 16];
+	static whitelist_uid_t cards[100000];
+	const uint32_t unknown = sizeof(cards) / sizeof(cards[0]);
+	bloom_filter_t filter;
+	uint32_t passed = 0;
+	uint32_t missed = 0;
+	uint32_t found = 0;
+	uint64_t start;
+	uint64_t filter_ns;
+	uint64_t full_ns;
+	uint32_t n;
+
+	bench_check(bloom_filter_init(&filter, storage, size, hashes), "Bloom filter size");
+	for (n = 0; n < whitelist.count; n++) {
+		bloom_filter_add(&filter, whitelist.uids[n].uid, whitelist.uids[n].size);
+	}
+	for (n = 0; n < whitelist.count; n++) {
+		missed += !bloom_filter_may_contain(&filter, whitelist.uids[n].uid, whitelist.uids[n].size);
+	}
+	bench_check(missed == 0, "Bloom filter has no false negatives");
+
+	// Unknown cards through the whitelist alone, then through filter and whitelist as check_access() does
+	for (n = 0; n < unknown; n++) {
+		cards[n].size = bench_make_uid(n, 0x5A5A5A5A, cards[n].uid);
+	}
+	start = bench_host_ns();
+	for (n = 0; n < unknown; n++) {
+		found += whitelist_find(&whitelist, cards[n].uid, cards[n].size);
+	}
+	full_ns = bench_host_ns() - start;
+	start = bench_host_ns();
+	for (n = 0; n < unknown; n++) {
+		if (bloom_filter_may_contain(&filter, cards[n].uid, cards[n].size)) {
+			passed++;
+			found += whitelist_find(&whitelist, cards[n].uid, cards[n].size);
+		}
+	}
+	filter_ns = bench_host_ns() - start;
+	bench_check(found == 0, "Bloom filter with whitelist rejects unknown cards");
+
+	printf("Bloom filter, %5lu cards, %6lu bytes, %2u hashes, %5.2f%% false positives (%5.2f%% expected), "
+			"%5.1f host ns (%5.1f without)\r\n", (unsigned long) whitelist.count, (unsigned long) size / 8, hashes,
+			100.0 * passed / unknown,
+			100.0 * pow(1.0 - exp(-(double) hashes * whitelist.count / size), hashes),
+			(double) filter_ns / unknown, (double) full_ns / unknown);
+}
+
+// Function to check that the cards of a range of test UIDs are enrolled or not
+static bool bench_store_has(uint32_t first, uint32_t last, bool enrolled) {
+	uint8_t uid[MFRC522_UID_MAX_SIZE];
+	uint8_t size;
+	uint32_t n;
+
+	for (n = first; n < last; n++) {
+		size = bench_make_uid(n, 0, uid);
+		if (credentials_find(uid, size) != enrolled) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Function to measure the flash credential store: enrolment, boot time replay, wear and power loss recovery
+static void bench_store(uint32_t cards) {
+	const credential_store_stats_t *stats = credential_store_get_stats();
+	const flash_sim_stats_t *flash = flash_sim_get_stats();
+	uint8_t uid[MFRC522_UID_MAX_SIZE];
+	uint8_t size;
+	bench_mark_t mark;
+	uint64_t start;
+	uint64_t elapsed;
+	uint64_t change_max = 0;
+	uint32_t erases;
+	uint32_t n;
+	bool ok = true;
+
+	flash_sim_reset();
+	bench_check(credential_store_init() && (stats->cards == 0), "Store formatted");
+
+	bench_start(&mark);
+	for (n = 0; n < cards; n++) {
+		size = bench_make_uid(n, 0, uid);
+		ok &= credential_store_add(uid, size);
+	}
+	bench_report("Store enrol (per card)", &mark, cards);
+	bench_check(ok, "Store enrol");
+
+	start = bench_host_ns();
+	ok = credential_store_init();
+	printf("Store mount, %5lu records             %10.1f host us\r\n", (unsigned long) stats->records,
+			(double) (bench_host_ns() - start) / 1000);
+	bench_check(ok && (stats->cards == cards) && bench_store_has(0, cards, true), "Store mount");
+
+	// Withdrawing cards fills the sector and moves the live cards to the other one
+	for (n = 0; n < cards; n += 2) {
+		size = bench_make_uid(n, 0, uid);
+		ok &= credential_store_remove(uid, size);
+	}
+	bench_check(ok && (stats->generation > 1), "Store compaction");
+	bench_check(credential_store_init() && (stats->cards == cards / 2), "Store mount after compaction");
+	for (n = 1; n < cards; n += 2) {
+		bench_check(bench_store_has(n - 1, n, false) && bench_store_has(n, n + 1, true), "Store contents");
+	}
+
+	// Power lost after the first word of a record: the card is not enrolled and the store still mounts
+	size = bench_make_uid(cards, 0, uid);
+	flash_sim_fail_after(1);
+	bench_check(!credential_store_add(uid, size), "Store add during power loss");
+	flash_sim_power_on();
+	bench_check(credential_store_init() && (stats->torn == 1) && !credentials_find(uid, size)
+			&& (stats->cards == cards / 2), "Store mount after torn record");
+
+	// Power lost while moving the live cards: the old sector stays active
+	while (stats->free) {
+		ok &= credential_store_add(uid, size);
+		ok &= credential_store_remove(uid, size);
+	}
+	n = stats->generation;
+	flash_sim_fail_after(100);
+	bench_check(ok && !credential_store_add(uid, size), "Store add during a cut compaction");
+	flash_sim_power_on();
+	bench_check(credential_store_init() && (stats->generation == n) && (stats->cards == cards / 2)
+			&& bench_store_has(1, 2, true), "Store mount after cut compaction");
+	bench_check(credential_store_add(uid, size) && (stats->generation == n + 1), "Store compaction after cut");
+
+	// The idle task compacts ahead of time, so over two sectors of changes none of them erases
+	n = stats->generation;
+	erases = flash->erases[CREDENTIAL_STORE_SECTOR_A] + flash->erases[CREDENTIAL_STORE_SECTOR_B];
+	while ((stats->generation < n + 2) && ok) {
+		start = sim_now();
+		ok &= credentials_find(uid, size) ? credential_store_remove(uid, size) : credential_store_add(uid, size);
+		elapsed = sim_now() - start;
+		change_max = (elapsed > change_max) ? elapsed : change_max;
+		ok &= (flash->erases[CREDENTIAL_STORE_SECTOR_A] + flash->erases[CREDENTIAL_STORE_SECTOR_B] == erases);
+		if (credential_store_prepare()) {
+			erases++;
+		}
+	}
+	printf("Store change (worst, idle compaction)    %10.1f us\r\n", (double) change_max * 1000000.0 / SIM_CORE_HZ);
+	bench_check(ok, "Store changes leave the erases to the idle task");
+	bench_check(credential_store_init() && (stats->cards == cards / 2 + credentials_find(uid, size))
+			&& bench_store_has(1, 2, true), "Store mount after idle compaction");
+
+	// Churn of a single card, the erases alternate between the two sectors
+	for (n = 0; n < 200000; n++) {
+		ok &= (n & 1) ? credential_store_remove(uid, size) : credential_store_add(uid, size);
+	}
+	bench_check(ok, "Store churn");
+	printf("Store erases, sector %d: %lu, sector %d: %lu, generation %lu\r\n", CREDENTIAL_STORE_SECTOR_A,
+			(unsigned long) flash->erases[CREDENTIAL_STORE_SECTOR_A], CREDENTIAL_STORE_SECTOR_B,
+			(unsigned long) flash->erases[CREDENTIAL_STORE_SECTOR_B], (unsigned long) stats->generation);
+	bench_check(flash->overwrites == 0, "Store only programs erased words");
+}
+
+static uint32_t bench_journal_found;
+static uint32_t bench_journal_last;
+static bool bench_journal_ordered;
+
+// Function to check the events returned by a journal query come in time order
+static void bench_journal_event(const journal_event_t *event) {
+	bench_journal_ordered &= (event->time >= bench_journal_last) && (event->decision == JOURNAL_GRANTED);
+	bench_journal_last = event->time;
+	bench_journal_found++;
+}
+
+// Function to run a journal query and check it against the events of a full scan
+static void bench_journal_query(const uint32_t *times, uint32_t count, uint32_t from, uint32_t to) {
+	uint32_t expected = 0;
+	uint32_t n;
+
+	for (n = 0; n < count; n++) {
+		expected += (times[n] >= from) && (times[n] <= to);
+	}
+	bench_journal_found = 0;
+	bench_journal_last = 0;
+	bench_journal_ordered = true;
+	bench_check((journal_query(from, to, bench_journal_event) == expected) && (bench_journal_found == expected)
+			&& bench_journal_ordered, "Journal range query");
+	// The index bounds the records read before the range to one stride
+	bench_check(journal_get_stats()->scanned <= expected + JOURNAL_INDEX_STRIDE + 1, "Journal query reads");
+}
+
+static uint32_t bench_journal_times[20000];
+
+// Function to copy the time of every event of a full scan
+static void bench_journal_time(const journal_event_t *event) {
+	bench_journal_times[bench_journal_found++] = event->time;
+}
+
+// Function to measure the access journal: staging and flash throughput, range queries, wrap and power loss
+static void bench_journal(uint32_t events) {
+	const journal_stats_t *stats = journal_get_stats();
+	const flash_sim_stats_t *flash = flash_sim_get_stats();
+	RC522_uid_t uid;
+	uint64_t log_ns = 0;
+	uint64_t flush_cycles = 0;
+	uint64_t flush_max = 0;
+	uint64_t prepare_max = 0;
+	uint64_t start;
+	uint64_t elapsed;
+	uint32_t erases;
+	uint32_t count;
+	uint32_t last;
+	uint32_t n;
+	bool ok = true;
+	bool deferred = true;
+
+	flash_sim_reset();
+	flash_sim_set_erase_max(true);
+	bench_check(journal_init() && (stats->events == 0), "Journal formatted");
+
+	// Four door decisions a second, staged and then written in batches as the main loop would. The idle task
+	// erases the oldest sector between batches, so no flush waits for an erase.
+	for (n = 0; n < events; n++) {
+		uid.size = bench_make_uid(n, 0, uid.uid);
+		sim_advance(SIM_CORE_HZ / 4);
+		start = bench_host_ns();
+		ok &= journal_log(JOURNAL_GRANTED, JOURNAL_REASON_ENROLLED_CARD, &uid);
+		log_ns += bench_host_ns() - start;
+		if (((n + 1) % JOURNAL_STAGING_SIZE == 0) || (n + 1 == events)) {
+			erases = stats->erases;
+			start = sim_now();
+			while (journal_flush(UINT8_MAX)) {
+			}
+			elapsed = sim_now() - start;
+			flush_cycles += elapsed;
+			flush_max = (elapsed > flush_max) ? elapsed : flush_max;
+			deferred &= (stats->erases == erases);
+
+			start = sim_now();
+			journal_prepare();
+			elapsed = sim_now() - start;
+			prepare_max = (elapsed > prepare_max) ? elapsed : prepare_max;
+		}
+	}
+	bench_check(ok && (stats->staged == 0) && (stats->failed == 0), "Journal append");
+	printf("Journal log (per event)                  %10.1f host ns\r\n", (double) log_ns / events);
+	printf("Journal flush (per event)                %10.1f us, %.0f events/s\r\n",
+			(double) flush_cycles * 1000000.0 / SIM_CORE_HZ / events,
+			(double) events * SIM_CORE_HZ / flush_cycles);
+	bench_check(deferred, "Journal flush leaves the erases to the idle task");
+	printf("Journal flush (worst batch of %2d)        %10.1f us\r\n", JOURNAL_STAGING_SIZE,
+			(double) flush_max * 1000000.0 / SIM_CORE_HZ);
+	printf("Journal prepare (worst, maximum erase)   %10.1f ms\r\n", (double) prepare_max * 1000.0 / SIM_CORE_HZ);
+	// One erase at most, plus the bookkeeping
+	bench_check(prepare_max < cycles_from_us((JOURNAL_ERASE_MAX_MS + 1) * 1000), "Journal prepare within one erase");
+	printf("Journal %lu events kept, %lu erases\r\n", (unsigned long) stats->events,
+			(unsigned long) stats->erases);
+	bench_check((stats->events > flash_sector_size(JOURNAL_SECTOR_A) / JOURNAL_RECORD_SIZE)
+			&& (stats->events < events) && (flash->erases[JOURNAL_SECTOR_A] + flash->erases[JOURNAL_SECTOR_B] > 2),
+			"Journal wrap");
+
+	bench_journal_found = 0;
+	count = journal_query(0, UINT32_MAX, bench_journal_time);
+	bench_check((count == stats->events) && (count <= 20000), "Journal full scan");
+	last = bench_journal_times[count - 1];
+	bench_journal_query(bench_journal_times, count, bench_journal_times[0], bench_journal_times[0]);
+	bench_journal_query(bench_journal_times, count, bench_journal_times[count / 3], bench_journal_times[count / 3] + 60);
+	bench_journal_query(bench_journal_times, count, last - 10, last + 10);
+	bench_journal_query(bench_journal_times, count, last + 1, UINT32_MAX);
+
+	start = bench_host_ns();
+	ok = journal_init();
+	printf("Journal mount, %5lu events             %10.1f host us\r\n", (unsigned long) stats->events,
+			(double) (bench_host_ns() - start) / 1000);
+	bench_check(ok && (stats->events == count) && (journal_time() > last), "Journal mount");
+	bench_journal_query(bench_journal_times, count, bench_journal_times[count / 2], bench_journal_times[count / 2] + 5);
+
+	// Power lost inside a record: the event is lost and the journal still mounts
+	flash_sim_fail_after(2);
+	bench_check(journal_log(JOURNAL_DENIED, JOURNAL_REASON_WRONG_PASSWORD, &uid) && (journal_flush(1) == 0)
+			&& (stats->failed == 1), "Journal flush during power loss");
+	flash_sim_power_on();
+	bench_check(journal_init() && (stats->torn == 1) && (stats->events == count), "Journal mount after torn event");
+
+	// A full staging buffer drops events instead of waiting for flash
+	ok = true;
+	for (n = 0; n < JOURNAL_STAGING_SIZE; n++) {
+		ok &= journal_log(JOURNAL_GRANTED, JOURNAL_REASON_WHITELIST, &uid);
+	}
+	bench_check(ok && !journal_log(JOURNAL_GRANTED, JOURNAL_REASON_WHITELIST, &uid) && (stats->dropped == 1),
+			"Journal full staging buffer");
+	bench_check((journal_flush(UINT8_MAX) == JOURNAL_STAGING_SIZE) && (stats->events == count + JOURNAL_STAGING_SIZE),
+			"Journal flush after drop");
+	bench_check(flash->overwrites == 0, "Journal only programs erased words");
+	flash_sim_set_erase_max(false);
+}
+
+// Functions standing in for the main loop tasks, each costs a fixed time
+static void bench_task_beeper(void) {
+	sim_advance(cycles_from_us(20));
+}
+
+static uint32_t bench_task_presented;
+
+// Function to read the field as the access task does, through the unchanged driver and the card model
+static void bench_task_rfid(void) {
+	RC522_event_t events[MFRC522_EVENTS_MAX];
+	uint8_t n = RC522_poll_events(events, MFRC522_EVENTS_MAX);
+
+	while (n--) {
+		bench_task_presented += (events[n].type == RC522_EVENT_PRESENTED);
+	}
+}
+
+static void bench_task_oled(void) {
+	sim_advance(cycles_from_us(12000));
+}
+
+static void bench_task_journal(void) {
+	sim_advance(cycles_from_us(80));
+}
+
+// Function to check the scheduler releases periodic tasks on time, by priority, and accounts for their run time
+static void bench_scheduler(uint32_t ms) {
+	const scheduler_task_stats_t *beeper;
+	const scheduler_task_stats_t *rfid;
+	const scheduler_task_stats_t *oled;
+	const scheduler_task_stats_t *journal;
+	uint32_t sleeps = 0;
+	uint32_t start;
+	uint32_t end;
+	int8_t card = -1;
+
+	beeper = scheduler_get_stats(scheduler_add("beeper", bench_task_beeper, 5, 0));
+	rfid = scheduler_get_stats(scheduler_add("rfid", bench_task_rfid, 20, 3));
+	oled = scheduler_get_stats(scheduler_add("oled", bench_task_oled, 50, 4));
+	journal = scheduler_get_stats(scheduler_add("journal", bench_task_journal, SCHEDULER_BACKGROUND, 0));
+	bench_check(beeper && rfid && oled && journal, "Scheduler tasks added");
+
+	// A card is held on the reader through the second quarter of the run
+	bench_task_presented = 0;
+	start = millis();
+	end = start + ms;
+	while ((int32_t) (millis() - end) < 0) {
+		if ((card < 0) && (millis() - start >= ms / 4) && (millis() - start < ms / 2)) {
+			card = mfrc522_sim_add_card(uid_double, 7, 0x00);
+		} else if ((card >= 0) && (millis() - start >= ms / 2)) {
+			mfrc522_sim_remove_card(card);
+			card = -1;
+		}
+		if (!scheduler_run_once()) {
+			sleeps++;
+			__WFI();
+		}
+	}
+	scheduler_dump(bench_write);
+	printf("Scheduler slept %lu times in %lu ms\r\n", (unsigned long) sleeps, (unsigned long) ms);
+
+	// Every release either runs or is counted late, the 12 ms OLED task makes the 5 ms beeper task late
+	bench_check((beeper->runs + beeper->late >= ms / 5 - 1) && (beeper->runs + beeper->late <= ms / 5 + 1)
+			&& (beeper->late > 0), "Scheduler periodic releases");
+	bench_check((rfid->runs + rfid->late >= ms / 20 - 1) && (rfid->runs + rfid->late <= ms / 20 + 1)
+			&& (oled->runs >= ms / 50 - 1) && (oled->late == 0), "Scheduler priorities");
+	bench_check((cycles_to_us(oled->max_cycles) >= 12000) && (cycles_to_us(oled->max_cycles) < 12010),
+			"Scheduler run time accounting");
+	bench_check(cycles_to_us(rfid->max_cycles) < 20000, "Scheduler RFID poll shorter than its period");
+	bench_check(bench_task_presented == 1, "Scheduler RFID task reads the card once");
+
+	// Every task gets to run and the core still sleeps, a background task does not keep it awake
+	bench_check((beeper->runs > 0) && (rfid->runs > 0) && (oled->runs > 0) && (journal->runs > 0),
+			"Scheduler runs every task");
+	bench_check((journal->runs <= ms + 1) && (sleeps >= ms / 2), "Scheduler sleeps between background runs");
+}
+
+// Function to hash a string and compare the digest with a hex string, the data is added in pieces of a given size
+static bool bench_sha256_check(const char *data, size_t length, size_t piece, const char *expected) {
+	sha256_t ctx;
+	uint8_t digest[SHA256_DIGEST_SIZE];
+	char hex[2 * SHA256_DIGEST_SIZE + 1];
+	size_t n;
+	uint8_t i;
+
+	sha256_init(&ctx);
+	for (n = 0; n < length; n += piece) {
+		sha256_update(&ctx, data + n, (length - n < piece) ? length - n : piece);
+	}
+	sha256_final(&ctx, digest);
+	for (i = 0; i < SHA256_DIGEST_SIZE; i++) {
+		sprintf(&hex[2 * i], "%02x", digest[i]);
+	}
+	return !strcmp(hex, expected);
+}
+
+// Function to check SHA-256 against the FIPS 180-4 examples and the salted PIN checks
+static void bench_pin(uint32_t runs) {
+	static const char *two_blocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+	static char million[1000000];
+	static const uint8_t salt[PIN_SALT_SIZE] = { 0x5A, 0x17, 0xC3, 0x08, 0x9E, 0x41, 0x66, 0xB2, 0x0D, 0xF4, 0x23,
+			0x88, 0x71, 0xAE, 0x3B, 0xD5 };
+	pin_hash_t stored;
+	uint64_t start;
+	uint32_t n;
+	bool ok = true;
+
+	bench_check(bench_sha256_check("abc", 3, 3,
+			"ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"), "SHA-256 one block");
+	bench_check(bench_sha256_check("", 0, 1,
+			"e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"), "SHA-256 empty message");
+	bench_check(bench_sha256_check(two_blocks, strlen(two_blocks), 5,
+			"248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"), "SHA-256 two blocks");
+	memset(million, 'a', sizeof(million));
+	bench_check(bench_sha256_check(million, sizeof(million), 1000,
+			"cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"), "SHA-256 million a");
+
+	pin_hash("1234", salt, &stored);
+	bench_check(pin_verify(&stored, "1234") && !pin_verify(&stored, "1235") && !pin_verify(&stored, "123")
+			&& !pin_verify(&stored, "12345") && !pin_verify(&stored, ""), "PIN verify");
+	bench_check(pin_equal(stored.hash, stored.hash, SHA256_DIGEST_SIZE)
+			&& !pin_equal(stored.hash, stored.salt, PIN_SALT_SIZE), "PIN compare");
+
+	start = bench_host_ns();
+	for (n = 0; n < runs; n++) {
+		ok &= !pin_verify(&stored, "0000");
+	}
+	bench_check(ok, "PIN verify wrong PIN");
+	printf("PIN verify (per check)                   %10.1f host ns\r\n", (double) (bench_host_ns() - start) / runs);
+}
+
+static volatile bool bench_spi_done;
+static volatile int8_t bench_spi_status;
+
+// Function to take the completion of an asynchronous SPI transfer
+static void bench_spi_complete(int8_t status) {
+	bench_spi_status = status;
+	bench_spi_done = true;
+}
+
+// Function to compare the core cycles of a polled and a DMA driven transfer of the same bytes
+static void bench_spi(void) {
+	static const uint32_t sizes[] = { 2, 8, MFRC522_FIFO_SIZE + 1, 256 };
+	uint8_t tx[256];
+	uint8_t rx[256];
+	uint64_t start;
+	uint64_t polled;
+	uint64_t dma;
+	uint64_t idle;
+	uint64_t total;
+	uint32_t i;
+	uint32_t j;
+	bool ok;
+
+	// Every address byte reads the version register, so both paths must return the same data
+	memset(tx, (MFRC522_REG_VERSION << 1) | 0x80, sizeof(tx));
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		memset(rx, 0, sizeof(rx));
+		start = sim_now();
+		bench_check(spi_transfer(tx, rx, sizes[i]) == 0, "Polled SPI transfer");
+		polled = sim_now() - start;
+		for (ok = true, j = 1; j < sizes[i]; j++) {
+			ok = ok && (rx[j] == 0x92);
+		}
+		bench_check(ok, "Polled SPI data");
+
+		// The core is free while the bytes are on the bus, only set-up and interrupt count against it
+		memset(rx, 0, sizeof(rx));
+		bench_spi_done = false;
+		idle = 0;
+		start = sim_now();
+		bench_check(spi_transfer_async(tx, rx, sizes[i], bench_spi_complete) == 0, "DMA SPI start");
+		bench_check(spi_transfer_async(tx, rx, sizes[i], bench_spi_complete) == -1, "DMA SPI refuses a second start");
+		while (spi_transfer_busy()) {
+			sim_advance(16);
+			idle += 16;
+		}
+		total = sim_now() - start;
+		dma = total - idle;
+		for (ok = true, j = 1; j < sizes[i]; j++) {
+			ok = ok && (rx[j] == 0x92);
+		}
+		bench_check(ok && bench_spi_done && (bench_spi_status == 0), "DMA SPI data and callback");
+
+		printf("SPI %3lu bytes: polled %6lu cycles, DMA %4lu cycles of core, %6lu cycles to complete\r\n",
+				(unsigned long) sizes[i], (unsigned long) polled, (unsigned long) dma, (unsigned long) total);
+	}
+}
+
+// Function to swallow driver output
+static void bench_discard(char *text) {
+	(void) text;
+}
+
+// Function to check the deferred log keeps the oldest entries and counts the ones it drops
+static void bench_log(void) {
+	bench_mark_t mark;
+	uint32_t dropped;
+	uint32_t i;
+
+	// Messages from the scenarios above
+	while (debug_log_flush(bench_write, UINT8_MAX)) {
+	}
+
+	dropped = debug_log_dropped();
+	bench_start(&mark);
+	for (i = 0; i < DEBUG_LOG_SIZE + 2; i++) {
+		debug_log(DEBUG_LOG_SPI_TXE_TIMEOUT, i, DEBUG_LOG_SIZE + 2);
+	}
+	bench_report("Deferred log record (per entry)", &mark, DEBUG_LOG_SIZE + 2);
+	bench_check(debug_log_dropped() - dropped == 2, "Full log drops new entries");
+	bench_check(debug_log_flush(bench_discard, 1) == 1, "Flush bounded by max");
+	bench_check(debug_log_flush(bench_discard, UINT8_MAX) == DEBUG_LOG_SIZE - 1, "Flush the remaining entries");
+}
+
+#ifdef MFRC522_TRACE_ENABLE
+// Function to trace one tap of a double size UID card for trace_decode
+static void bench_trace(void) {
+	RC522_uid_t found[MFRC522_INVENTORY_MAX];
+	int8_t card = mfrc522_sim_add_card(uid_double, 7, 0x00);
+
+	rfid_trace_clear();
+	RC522_inventory(PICC_REQIDL, found, MFRC522_INVENTORY_MAX);
+	rfid_trace_dump(bench_write);
+	mfrc522_sim_remove_card(card);
+}
+#endif
+
+int main(void) {
+	static const uint8_t *const one_single[] = { uid_single };
+	static const uint8_t *const one_double[] = { uid_double };
+	static const uint8_t *const one_triple[] = { uid_triple };
+	static const uint8_t *const two_single[] = { uid_single, uid_single_2 };
+	static const uint8_t *const stack[] = { uid_single, uid_double, uid_triple };
+	static const uint8_t *const tree[] = { uid_tree[0], uid_tree[1], uid_tree[2] };
+	static const uint8_t *const last_bit[] = { uid_last_bit[0], uid_last_bit[1] };
+	static const uint8_t size_single[] = { 4, 4 };
+	static const uint8_t size_double[] = { 7 };
+	static const uint8_t size_triple[] = { 10 };
+	static const uint8_t size_stack[] = { 4, 7, 10 };
+	static const uint8_t size_tree[] = { 4, 4, 4 };
+	RC522_uid_t found[MFRC522_INVENTORY_MAX];
+	bench_mark_t mark;
+	uint32_t i;
+
+	mfrc522_sim_reset();
+	systick_init_ms(SIM_CORE_HZ);
+
+	bench_start(&mark);
+	RC522_init();
+	bench_report("RC522_init", &mark, 1);
+	printf("SPI clock %lu Hz\r\n", (unsigned long) spi_get_clock_hz());
+	bench_check(RC522_crc_self_test(), "CRC_A self test");
+	bench_spi();
+
+	bench_start(&mark);
+	for (i = 0; i < 10; i++) {
+		bench_check(RC522_inventory(PICC_REQIDL, found, MFRC522_INVENTORY_MAX) == 0, "Empty field");
+	}
+	bench_report("Empty field poll", &mark, 10);
+
+	bench_inventory("Single size UID", one_single, size_single, 1);
+	bench_inventory("Double size UID", one_double, size_double, 1);
+	bench_inventory("Triple size UID", one_triple, size_triple, 1);
+	bench_inventory("Two colliding single size UIDs", two_single, size_single, 2);
+	bench_inventory("Stack of 4, 7 and 10 byte UIDs", stack, size_stack, 3);
+	bench_inventory("Three UIDs, nested collisions", tree, size_tree, 3);
+	bench_inventory("Two UIDs colliding on bit 32", last_bit, size_single, 2);
+
+	bench_mifare();
+	bench_events();
+	bench_lpcd();
+	bench_log();
+	bench_credentials(10);
+	bench_credentials(1000);
+	bench_credentials(10000);
+	bench_credential_pool();
+	bench_whitelist();
+	bench_bloom(1 << 15, 2);
+	bench_bloom(1 << 16, 5);
+	bench_bloom(1 << 17, 9);
+	bench_bloom(1 << 18, 12);
+	// Size the firmware derives for the card filter, 10 bits per card with 7 hashes
+	bench_check((BLOOM_FILTER_SIZE_FOR(7730) == 8192) && (BLOOM_FILTER_SIZE_FOR(8192) == 8192)
+			&& (BLOOM_FILTER_SIZE_FOR(8193) == 16384), "Bloom filter size rounding");
+	bench_bloom(BLOOM_FILTER_SIZE_FOR(whitelist.count * 10), 7);
+	bench_store(10000);
+	bench_journal(20000);
+	bench_scheduler(2000);
+	bench_pin(100000);
+#ifdef MFRC522_TRACE_ENABLE
+	bench_trace();
+#endif
+
+	printf("%d check(s) failed\r\n", failures);
+	return failures;
+}
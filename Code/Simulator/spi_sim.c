@@ -0,0 +1,133 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   spi_sim.c
+* @brief  A file defining the spi.h APIs on top of the MFRC522 model. Every byte costs its bus time at the
+*         selected SPI clock. spi_transmit(), spi_transfer() and spi_transfer_async() start a chip-select frame,
+*         spi_receive() continues the frame of the previous call. The polled functions keep the core busy for
+*         the whole transfer, spi_transfer_async() only charges the DMA set-up and completion interrupt and
+*         leaves the bus time to the caller.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 5, 2023
+* @revision 1.0
+*
+*/
+
+#include <stddef.h>
+#include "spi.h"
+#include "stm32f4xx.h"
+#include "mfrc522_sim.h"
+
+static uint16_t spi_divider = 32;
+static uint32_t spi_transaction_count = 0;
+static bool spi_dma_busy = false;
+static uint64_t spi_dma_done;
+static spi_callback_t spi_dma_callback = NULL;
+static uint32_t spi_dma_count = 0;
+
+// Function to exchange bytes with the model
+static void spi_sim_exchange(const uint8_t *tx, uint8_t *rx, uint32_t size) {
+	uint32_t i;
+
+	for (i = 0; i < size; i++) {
+		uint8_t data = mfrc522_sim_spi_byte(tx ? tx[i] : 0);
+		if (rx) {
+			rx[i] = data;
+		}
+	}
+	spi_transaction_count++;
+}
+
+// Function to exchange bytes with the core polling the status register for every byte
+static void spi_sim_exchange_polled(const uint8_t *tx, uint8_t *rx, uint32_t size) {
+	spi_sim_exchange(tx, rx, size);
+	sim_advance(SIM_SPI_OVERHEAD + (uint64_t) size * (8 * spi_divider + SIM_SPI_POLL_BYTE));
+}
+
+void spi_init(void) {
+	spi_divider = 32;
+}
+
+int8_t spi_set_clock_divider(uint16_t divider) {
+	uint32_t br = 0;
+
+	while ((br < 8) && ((2U << br) != divider)) {
+		br++;
+	}
+	if (br == 8) {
+		return -1;
+	}
+	spi_divider = divider;
+	return 0;
+}
+
+uint16_t spi_get_clock_divider(void) {
+	return spi_divider;
+}
+
+uint32_t spi_get_clock_hz(void) {
+	return SystemCoreClock / spi_divider;
+}
+
+int8_t spi_transmit(uint8_t *data, uint32_t size) {
+	mfrc522_sim_spi_begin();
+	spi_sim_exchange_polled(data, NULL, size);
+	return 0;
+}
+
+int8_t spi_receive(uint8_t *data, uint32_t size) {
+	spi_sim_exchange_polled(NULL, data, size);
+	return 0;
+}
+
+int8_t spi_transfer(const uint8_t *tx, uint8_t *rx, uint32_t size) {
+	mfrc522_sim_spi_begin();
+	spi_sim_exchange_polled(tx, rx, size);
+	return 0;
+}
+
+uint32_t spi_get_transaction_count(void) {
+	return spi_transaction_count;
+}
+
+// The bytes are exchanged at once, the completion interrupt is due once their bus time has passed
+int8_t spi_transfer_async(const uint8_t *tx, uint8_t *rx, uint32_t size,
+		spi_callback_t callback) {
+	if (spi_dma_busy || (size == 0) || (size > 0xFFFF)) {
+		return -1;
+	}
+	sim_advance(SIM_DMA_SETUP);
+	mfrc522_sim_spi_begin();
+	spi_sim_exchange(tx, rx, size);
+	spi_dma_busy = true;
+	spi_dma_callback = callback;
+	spi_dma_done = sim_now() + (uint64_t) size * 8 * spi_divider;
+	spi_dma_count++;
+	sim_wake_at(spi_dma_done);
+	return 0;
+}
+
+// The completion interrupt runs on the first check after the last byte
+bool spi_transfer_busy(void) {
+	if (spi_dma_busy && (sim_now() >= spi_dma_done)) {
+		sim_advance(SIM_DMA_IRQ);
+		spi_dma_busy = false;
+		if (spi_dma_callback) {
+			spi_dma_callback(0);
+		}
+	}
+	return spi_dma_busy;
+}
+
+uint32_t spi_sim_dma_count(void) {
+	return spi_dma_count;
+}
@@ -0,0 +1,93 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   stm32_sim.c
+* @brief  A file defining the simulated time base, the delay.h APIs on top of it and the RAM backed
+*         peripherals declared by the host stm32f4xx.h.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 5, 2023
+* @revision 1.0
+*
+*/
+
+#include "stm32f4xx.h"
+#include "delay.h"
+#include "mfrc522_sim.h"
+
+#define SIM_CYCLES_PER_CALL	4	// Instructions spent by the caller around every time base read
+
+GPIO_TypeDef sim_GPIOA;
+GPIO_TypeDef sim_GPIOB;
+RCC_TypeDef sim_RCC;
+SYSCFG_TypeDef sim_SYSCFG;
+EXTI_TypeDef sim_EXTI;
+uint32_t SystemCoreClock = SIM_CORE_HZ;
+
+static uint64_t sim_cycles = 0;
+static uint64_t sim_wake = 0;
+
+// Function to get the simulated time in core cycles
+uint64_t sim_now(void) {
+	return sim_cycles;
+}
+
+// Function to advance the simulated time
+void sim_advance(uint64_t count) {
+	sim_cycles += count;
+}
+
+// Function to schedule a peripheral interrupt
+void sim_wake_at(uint64_t cycle) {
+	sim_wake = cycle;
+}
+
+// Function to sleep until the next SysTick or scheduled peripheral interrupt
+void sim_wfi(void) {
+	uint64_t tick = SystemCoreClock / 1000;
+	uint64_t next = (sim_cycles / tick + 1) * tick;
+
+	if ((sim_wake > sim_cycles) && (sim_wake < next)) {
+		next = sim_wake;
+	}
+	sim_cycles = next;
+}
+
+void systick_init_ms(uint32_t freq) {
+	SystemCoreClock = freq;
+}
+
+// Busy-wait loops make progress because every read of the time base costs a few cycles
+uint32_t cycles(void) {
+	sim_cycles += SIM_CYCLES_PER_CALL;
+	return (uint32_t) sim_cycles;
+}
+
+uint32_t cycles_from_us(uint32_t us) {
+	return us * (SystemCoreClock / 1000000);
+}
+
+uint32_t cycles_to_us(uint32_t count) {
+	return count / (SystemCoreClock / 1000000);
+}
+
+uint32_t millis(void) {
+	sim_cycles += SIM_CYCLES_PER_CALL;
+	return (uint32_t) (sim_cycles / (SystemCoreClock / 1000));
+}
+
+void delay(uint32_t ms) {
+	uint32_t start = millis();
+
+	do {
+		;
+	} while (millis() - start < ms);
+}
@@ -0,0 +1,160 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   trace_decode.c
+* @brief  A host program decoding an RC522 register trace dump (rfid_trace_dump() output, captured from USART2
+*         or from the simulator) into a per-command latency breakdown of RC522_request, RC522_anti_coll and
+*         RC522_halt. Lines outside the TRACE ... END block are ignored.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 8, 2023
+* @revision 1.0
+*
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "rfid_trace.h"
+
+#define MAX_DEPTH	8
+#define MAX_IDS		8
+
+/* A driver call that has begun but not ended yet */
+typedef struct {
+	uint8_t id;
+	uint32_t start;
+	uint32_t spi;
+	uint32_t shadow;
+	uint32_t polls;
+	uint32_t first_poll;
+	uint32_t last_poll;
+} open_call_t;
+
+/* Totals of one driver call */
+typedef struct {
+	uint32_t calls;
+	uint64_t cycles;
+	uint32_t max_cycles;
+	uint64_t wait_cycles;
+	uint32_t spi;
+	uint32_t shadow;
+	uint32_t polls;
+} call_stats_t;
+
+static const char *call_names[MAX_IDS] = {
+	[RFID_TRACE_ID_REQUEST] = "RC522_request",
+	[RFID_TRACE_ID_ANTI_COLL] = "RC522_anti_coll",
+	[RFID_TRACE_ID_HALT] = "RC522_halt",
+};
+
+int main(void) {
+	open_call_t stack[MAX_DEPTH];
+	call_stats_t stats[MAX_IDS] = { 0 };
+	char line[128];
+	unsigned long entries = 0;
+	unsigned long per_us = 0;
+	unsigned long cyc;
+	unsigned int type;
+	unsigned int reg;
+	unsigned int value;
+	unsigned int repeat;
+	unsigned long decoded = 0;
+	int depth = 0;
+	int in_trace = 0;
+	int d;
+	int id;
+
+	while (fgets(line, sizeof(line), stdin)) {
+		if (!in_trace) {
+			in_trace = (sscanf(line, "TRACE %lu %lu", &entries, &per_us) == 2);
+			continue;
+		}
+		if (!strncmp(line, "END", 3)) {
+			break;
+		}
+		if (sscanf(line, "%lx %x %x %x %x", &cyc, &type, &reg, &value, &repeat) != 5) {
+			continue;
+		}
+		decoded++;
+
+		switch (type) {
+		case RFID_TRACE_BEGIN:
+			if (depth < MAX_DEPTH) {
+				memset(&stack[depth], 0, sizeof(stack[depth]));
+				stack[depth].id = reg % MAX_IDS;
+				stack[depth].start = cyc;
+				depth++;
+			}
+			break;
+		case RFID_TRACE_END:
+			// A ring buffer that wrapped can lose the BEGIN of the first calls
+			if ((depth == 0) || (stack[depth - 1].id != reg % MAX_IDS)) {
+				break;
+			}
+			depth--;
+			id = stack[depth].id;
+			stats[id].calls++;
+			stats[id].cycles += (uint32_t) (cyc - stack[depth].start);
+			if ((uint32_t) (cyc - stack[depth].start) > stats[id].max_cycles) {
+				stats[id].max_cycles = cyc - stack[depth].start;
+			}
+			if (stack[depth].polls) {
+				stats[id].wait_cycles += stack[depth].last_poll - stack[depth].first_poll;
+			}
+			stats[id].spi += stack[depth].spi;
+			stats[id].shadow += stack[depth].shadow;
+			stats[id].polls += stack[depth].polls;
+			break;
+		default:
+			// Register traffic counts for every call it happens in
+			for (d = 0; d < depth; d++) {
+				if ((type == RFID_TRACE_READ_SHADOW) || (type == RFID_TRACE_WRITE_SKIP)) {
+					stack[d].shadow++;
+					continue;
+				}
+				stack[d].spi += 1 + repeat;
+				if ((type == RFID_TRACE_READ)
+						&& ((reg == MFRC522_REG_COMM_IRQ) || (reg == MFRC522_REG_DIV_IRQ))) {
+					if (stack[d].polls == 0) {
+						stack[d].first_poll = cyc;
+					}
+					stack[d].polls += 1 + repeat;
+					stack[d].last_poll = cyc;
+				}
+			}
+			break;
+		}
+	}
+
+	if (!in_trace || (per_us == 0)) {
+		fprintf(stderr, "No TRACE block found\n");
+		return 1;
+	}
+
+	printf("%lu of %lu entries decoded, %lu cycles per us\n", decoded, entries, per_us);
+	printf("%-16s %6s %10s %10s %10s %8s %8s %8s\n", "command", "calls", "avg us", "max us",
+			"wait us", "SPI", "shadow", "polls");
+	for (id = 0; id < MAX_IDS; id++) {
+		if (stats[id].calls == 0) {
+			continue;
+		}
+		printf("%-16s %6u %10.1f %10.1f %10.1f %8.1f %8.1f %8.1f\n",
+				call_names[id] ? call_names[id] : "unknown", stats[id].calls,
+				(double) stats[id].cycles / per_us / stats[id].calls,
+				(double) stats[id].max_cycles / per_us,
+				(double) stats[id].wait_cycles / per_us / stats[id].calls,
+				(double) stats[id].spi / stats[id].calls,
+				(double) stats[id].shadow / stats[id].calls,
+				(double) stats[id].polls / stats[id].calls);
+	}
+	return 0;
+}
@@ -0,0 +1,276 @@
+/*****************************************************************************
+* Copyright (C) 2023 by Krishna Suhagiya and Sriya Garde
+*
+* Redistribution, modification or use of this software in source or binary
+* forms is permitted as long as the files maintain this copyright. Users are
+* permitted to modify this and use it to learn about the field of embedded
+* software. Krishna Suhagiya, Sriya Garde and the University of Colorado are not liable for
+* any misuse of this material.
+*
+*****************************************************************************/
+/**
+* @file   whitelist_gen.c
+* @brief  A host program building the site whitelist. It reads a CSV with one UID per line in the first column
+*         (hex bytes, optionally separated by spaces, ':' or '-'; '#' starts a comment and a header line is
+*         skipped), finds a minimal perfect hash by hash and displace, and prints whitelist_table.c on stdout.
+*         Sizes are reported on stderr. An optional second argument names a header receiving the number of
+*         cards, which sizes the card filter of the firmware at compile time.
+*
+* @author Krishna Suhagiya and Sriya Garde
+* @date   December 11, 2023
+* @revision 1.0
+*
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "whitelist.h"
+
+#define MAX_CARDS	65535	// The displacement holds 16-bit values
+#define MAX_SALTS	64
+
+static whitelist_uid_t *cards;
+static uint32_t card_count = 0;
+static uint32_t *bucket_sizes;
+
+// Function to parse the UID column of a CSV line, it returns the size or 0 if the line holds no UID
+static int parse_uid(const char *line, uint8_t *uid) {
+	int size = 0;
+	int digits = 0;
+	int c;
+
+	for (; *line && (*line != ',') && (*line != '#'); line++) {
+		c = (unsigned char) *line;
+		if (isxdigit(c)) {
+			if (size == MFRC522_UID_MAX_SIZE) {
+				return -1;
+			}
+			uid[size] = (uid[size] << 4) | (isdigit(c) ? c - '0' : tolower(c) - 'a' + 10);
+			if (++digits == 2) {
+				digits = 0;
+				size++;
+			}
+		} else if (isspace(c) || (c == ':') || (c == '-')) {
+			if (digits) {
+				return -1;
+			}
+		} else {
+			return -1;
+		}
+	}
+	if (digits) {
+		return -1;
+	}
+	return size;
+}
+
+// Function to read the cards of the CSV file
+static bool read_csv(FILE *file) {
+	char line[256];
+	uint8_t uid[MFRC522_UID_MAX_SIZE];
+	unsigned long number = 0;
+	uint32_t c;
+	int size;
+
+	cards = calloc(MAX_CARDS, sizeof(*cards));
+	while (fgets(line, sizeof(line), file)) {
+		number++;
+		memset(uid, 0, sizeof(uid));
+		size = parse_uid(line, uid);
+		if (size == 0) {
+			continue;
+		}
+		if ((size < 0) && (number == 1)) {
+			continue;	// Header
+		}
+		if ((size != 4) && (size != 7) && (size != 10)) {
+			fprintf(stderr, "line %lu: not a 4, 7 or 10 byte UID\n", number);
+			return false;
+		}
+		for (c = 0; c < card_count; c++) {
+			if ((cards[c].size == size) && !memcmp(cards[c].uid, uid, size)) {
+				fprintf(stderr, "line %lu: duplicate UID\n", number);
+				return false;
+			}
+		}
+		if (card_count == MAX_CARDS) {
+			fprintf(stderr, "line %lu: more than %d cards\n", number, MAX_CARDS);
+			return false;
+		}
+		cards[card_count].size = size;
+		memcpy(cards[card_count].uid, uid, size);
+		card_count++;
+	}
+	return true;
+}
+
+// Function to order buckets by decreasing number of cards
+static int compare_buckets(const void *a, const void *b) {
+	uint32_t sa = bucket_sizes[*(const uint32_t*) a];
+	uint32_t sb = bucket_sizes[*(const uint32_t*) b];
+
+	return (sa < sb) - (sa > sb);
+}
+
+// Function to find a displacement for every bucket with a given salt
+static bool build(whitelist_table_t *table, uint32_t *displace, uint32_t *slot_card) {
+	uint32_t (*hash)[3] = malloc(card_count * sizeof(*hash));
+	uint32_t *order = malloc(table->buckets * sizeof(*order));
+	uint32_t *start = calloc(table->buckets + 1, sizeof(*start));
+	uint32_t *members = malloc(card_count * sizeof(*members));
+	uint32_t *fill = calloc(table->buckets, sizeof(*fill));
+	uint32_t slots[64];
+	uint32_t b, c, k, j, d0, d1;
+	bool placed = true;
+
+	bucket_sizes = calloc(table->buckets, sizeof(*bucket_sizes));
+	for (c = 0; c < card_count; c++) {
+		whitelist_hash(table->salt, cards[c].uid, cards[c].size, hash[c]);
+		bucket_sizes[hash[c][0] % table->buckets]++;
+	}
+	for (b = 0; b < table->buckets; b++) {
+		start[b + 1] = start[b] + bucket_sizes[b];
+		order[b] = b;
+	}
+	for (c = 0; c < card_count; c++) {
+		b = hash[c][0] % table->buckets;
+		members[start[b] + fill[b]++] = c;
+	}
+	qsort(order, table->buckets, sizeof(*order), compare_buckets);
+
+	for (c = 0; c < card_count; c++) {
+		slot_card[c] = UINT32_MAX;
+	}
+	for (k = 0; (k < table->buckets) && placed; k++) {
+		b = order[k];
+		displace[b] = 0;
+		if ((bucket_sizes[b] == 0) || (bucket_sizes[b] > 64)) {
+			placed = (bucket_sizes[b] == 0);
+			continue;
+		}
+		placed = false;
+		for (d0 = 0; (d0 < card_count) && (d0 <= 0xFFFF) && !placed; d0++) {
+			for (d1 = 0; (d1 < card_count) && !placed; d1++) {
+				displace[b] = (d0 << 16) | d1;
+				placed = true;
+				for (j = 0; (j < bucket_sizes[b]) && placed; j++) {
+					slots[j] = whitelist_slot(table, hash[members[start[b] + j]]);
+					placed = (slot_card[slots[j]] == UINT32_MAX);
+					for (c = 0; (c < j) && placed; c++) {
+						placed = (slots[c] != slots[j]);
+					}
+				}
+			}
+		}
+		if (placed) {
+			for (j = 0; j < bucket_sizes[b]; j++) {
+				slot_card[slots[j]] = members[start[b] + j];
+			}
+		}
+	}
+
+	free(hash);
+	free(order);
+	free(start);
+	free(members);
+	free(fill);
+	free(bucket_sizes);
+	return placed;
+}
+
+// Function to print whitelist_table.c
+static void print_table(const whitelist_table_t *table, const uint32_t *displace, const uint32_t *slot_card) {
+	uint32_t b;
+	uint32_t s;
+	uint8_t i;
+
+	printf("/*\r\n * Generated by Simulator/whitelist_gen from whitelist.csv, do not edit.\r\n"
+			" * %lu cards, %lu buckets, salt %lu.\r\n */\r\n\r\n#include \"whitelist.h\"\r\n\r\n",
+			(unsigned long) table->count, (unsigned long) table->buckets, (unsigned long) table->salt);
+
+	printf("static const uint32_t whitelist_displace[%lu] = {", (unsigned long) table->buckets);
+	for (b = 0; b < table->buckets; b++) {
+		printf("%s0x%08lx,", (b % 6) ? " " : "\r\n\t", (unsigned long) displace[b]);
+	}
+	printf("\r\n};\r\n\r\n");
+
+	printf("static const whitelist_uid_t whitelist_uids[%lu] = {", (unsigned long) (table->count ? table->count : 1));
+	for (s = 0; s < table->count; s++) {
+		const whitelist_uid_t *card = &cards[slot_card[s]];
+		printf("\r\n\t{ %u, {", card->size);
+		for (i = 0; i < card->size; i++) {
+			printf("%s0x%02X", i ? ", " : " ", card->uid[i]);
+		}
+		printf(" } },");
+	}
+	printf("%s\r\n};\r\n\r\n", table->count ? "" : " 0");
+
+	printf("const whitelist_table_t whitelist = { %lu, %lu, %lu, whitelist_displace, whitelist_uids };\r\n",
+			(unsigned long) table->count, (unsigned long) table->buckets, (unsigned long) table->salt);
+}
+
+// Function to write the header holding the number of cards
+static bool write_size_header(const char *path, uint32_t count) {
+	FILE *file = fopen(path, "wb");
+
+	if (!file) {
+		perror(path);
+		return false;
+	}
+	fprintf(file, "/*\r\n * Generated by Simulator/whitelist_gen from whitelist.csv, do not edit.\r\n */\r\n\r\n"
+			"#ifndef __WHITELIST_SIZE_H\r\n#define __WHITELIST_SIZE_H\r\n\r\n"
+			"#define WHITELIST_CARDS\t%lu\t\t// Cards of the whitelist compiled into the firmware\r\n\r\n"
+			"#endif /* __WHITELIST_SIZE_H */\r\n", (unsigned long) count);
+	return fclose(file) == 0;
+}
+
+int main(int argc, char **argv) {
+	whitelist_table_t table = { 0 };
+	uint32_t *displace;
+	uint32_t *slot_card;
+	FILE *file;
+
+	if ((argc != 2) && (argc != 3)) {
+		fprintf(stderr, "usage: %s whitelist.csv [whitelist_size.h] > whitelist_table.c\n", argv[0]);
+		return 2;
+	}
+	file = fopen(argv[1], "r");
+	if (!file) {
+		perror(argv[1]);
+		return 1;
+	}
+	if (!read_csv(file)) {
+		return 1;
+	}
+	fclose(file);
+
+	table.count = card_count;
+	table.buckets = (card_count + WHITELIST_BUCKET_SIZE - 1) / WHITELIST_BUCKET_SIZE;
+	if (table.buckets == 0) {
+		table.buckets = 1;
+	}
+	displace = calloc(table.buckets, sizeof(*displace));
+	slot_card = calloc(card_count ? card_count : 1, sizeof(*slot_card));
+	table.displace = displace;
+	table.uids = cards;
+
+	// A salt fails when two cards share all three hashes or a bucket cannot be placed
+	while (card_count && !build(&table, displace, slot_card)) {
+		if (++table.salt == MAX_SALTS) {
+			fprintf(stderr, "no perfect hash found\n");
+			return 1;
+		}
+	}
+
+	print_table(&table, displace, slot_card);
+	if ((argc == 3) && !write_size_header(argv[2], table.count)) {
+		return 1;
+	}
+	fprintf(stderr, "%lu cards, %lu buckets, salt %lu, %lu bytes of flash\n", (unsigned long) table.count,
+			(unsigned long) table.buckets, (unsigned long) table.salt,
+			(unsigned long) (table.buckets * sizeof(uint32_t) + table.count * sizeof(whitelist_uid_t)
+					+ sizeof(whitelist_table_t)));
+	return 0;
+}